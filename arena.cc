@@ -0,0 +1,110 @@
+/// \file arena.cc
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#include <stddef.h>
+#include <algorithm>
+#include <iostream>
+#include <new>
+
+#include "arena.h"
+
+namespace rhpman {
+
+Arena* Arena::s_runArena = nullptr;
+
+std::ostream& operator<<(std::ostream& os, const ArenaStats& stats) {
+  return os << "{allocations: " << stats.allocations << ", deallocations: " << stats.deallocations
+            << ", reuses: " << stats.reuses << ", oversized: " << stats.oversized
+            << ", bytesRequested: " << stats.bytesRequested << ", blocks: " << stats.blocks
+            << ", bytesReserved: " << stats.bytesReserved << "}";
+}
+
+void* Arena::Allocate(size_t bytes) {
+  m_stats.allocations++;
+  m_stats.bytesRequested += bytes;
+
+  if (bytes > kMaxSmallSize) {
+    m_stats.oversized++;
+    return ::operator new(bytes);
+  }
+
+  const size_t cls = sizeClass(std::max<size_t>(bytes, 1));
+  FreeNode* node = m_freeLists[cls];
+  if (node != nullptr) {
+    m_freeLists[cls] = node->next;
+    m_stats.reuses++;
+    return node;
+  }
+
+  const size_t rounded = cls * kGranularity;
+  if (m_cursor == nullptr || static_cast<size_t>(m_end - m_cursor) < rounded) {
+    reserveBlock();
+  }
+  void* result = m_cursor;
+  m_cursor += rounded;
+  return result;
+}
+
+void Arena::Deallocate(void* ptr, size_t bytes) {
+  if (ptr == nullptr) return;
+  m_stats.deallocations++;
+
+  if (bytes > kMaxSmallSize) {
+    ::operator delete(ptr);
+    return;
+  }
+
+  const size_t cls = sizeClass(std::max<size_t>(bytes, 1));
+  FreeNode* node = static_cast<FreeNode*>(ptr);
+  node->next = m_freeLists[cls];
+  m_freeLists[cls] = node;
+}
+
+void Arena::Release() {
+  for (void* block : m_blocks) {
+    ::operator delete(block);
+  }
+  m_blocks.clear();
+  std::fill(std::begin(m_freeLists), std::end(m_freeLists), nullptr);
+  m_cursor = nullptr;
+  m_end = nullptr;
+}
+
+void Arena::reserveBlock() {
+  // The tail of the previous block is simply abandoned; it is smaller than
+  // the largest size class, so at most kMaxSmallSize bytes are wasted.
+  char* block = static_cast<char*>(::operator new(kBlockSize));
+  m_blocks.push_back(block);
+  m_cursor = block;
+  m_end = block + kBlockSize;
+  m_stats.blocks++;
+  m_stats.bytesReserved += kBlockSize;
+}
+
+// static
+void Arena::EnableRunArena() {
+  if (s_runArena == nullptr) {
+    s_runArena = new Arena();
+  }
+}
+
+// static
+void Arena::ReleaseRunArena() {
+  delete s_runArena;
+  s_runArena = nullptr;
+}
+
+}  // namespace rhpman
@@ -0,0 +1,188 @@
+/// \file arena.h
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+/// \brief Declares a run-lifetime arena allocator for the small buffers that
+///     the RHPMAN scheme creates and destroys at a high rate. Only the
+///     containers of DataSet use it so far.
+///
+///     Memory handed out by an Arena is carved from large blocks and recycled
+///     through per-size free lists, so the hot path rarely reaches malloc.
+///     Every block is released at once at the end of the run.
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef __arena_h
+#define __arena_h
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <iostream>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace rhpman {
+
+/// \brief Allocation counters collected by an Arena.
+struct ArenaStats {
+  /// Number of allocation requests.
+  uint64_t allocations = 0;
+  /// Number of deallocation requests.
+  uint64_t deallocations = 0;
+  /// Allocations served from a free list instead of fresh block memory.
+  uint64_t reuses = 0;
+  /// Allocations too large for the arena, forwarded to the global heap.
+  uint64_t oversized = 0;
+  /// Total bytes requested by callers.
+  uint64_t bytesRequested = 0;
+  /// Number of blocks reserved from the global heap.
+  uint64_t blocks = 0;
+  /// Total bytes reserved from the global heap for blocks.
+  uint64_t bytesReserved = 0;
+
+  friend std::ostream& operator<<(std::ostream& os, const ArenaStats& stats);
+};
+
+/// \brief A bump allocator with size-class free lists.
+///     Small allocations are rounded up to a multiple of kGranularity and
+///     carved from blocks of kBlockSize bytes. Freed memory is pushed onto the
+///     free list of its size class, and is reused by later allocations of the
+///     same class. Blocks are only returned to the heap by Release.
+///
+///     An Arena is not thread-safe; it must only be used from the simulator
+///     thread.
+class Arena {
+ public:
+  static constexpr size_t kBlockSize = 64 * 1024;
+  static constexpr size_t kGranularity = 16;
+  static constexpr size_t kMaxSmallSize = 256;
+
+  Arena() : m_cursor(nullptr), m_end(nullptr), m_freeLists(), m_blocks(), m_stats() {}
+  ~Arena() { Release(); }
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /// \brief Allocates memory for an object of the given size.
+  ///
+  /// \param bytes The number of bytes to allocate.
+  /// \return void* Memory aligned to kGranularity bytes.
+  void* Allocate(size_t bytes);
+
+  /// \brief Returns memory obtained from Allocate to the arena.
+  ///
+  /// \param ptr The memory to return.
+  /// \param bytes The size that was passed to Allocate.
+  void Deallocate(void* ptr, size_t bytes);
+
+  /// \brief Frees every block held by this arena at once.
+  ///     Any memory still handed out becomes invalid.
+  void Release();
+
+  const ArenaStats& GetStats() const { return m_stats; }
+
+  /// \brief Constructs an object in arena memory.
+  template <typename T, typename... Args>
+  T* New(Args&&... args) {
+    return new (Allocate(sizeof(T))) T(std::forward<Args>(args)...);
+  }
+
+  /// \brief Destroys an object created by New and recycles its memory.
+  template <typename T>
+  void Delete(T* obj) {
+    if (obj == nullptr) return;
+    obj->~T();
+    Deallocate(obj, sizeof(T));
+  }
+
+  /// \brief Enables the arena shared by all objects of the current run.
+  ///     Must be called before any object using the run arena is created.
+  static void EnableRunArena();
+
+  /// \brief Releases the run arena and all of its memory.
+  ///     Must be called after every object using the run arena is destroyed.
+  static void ReleaseRunArena();
+
+  /// \brief Gets the run arena.
+  ///
+  /// \return Arena* The run arena, or nullptr if it is not enabled, in which
+  ///     case callers should use the global heap.
+  static Arena* GetRunArena() { return s_runArena; }
+
+ private:
+  static size_t sizeClass(size_t bytes) { return (bytes + kGranularity - 1) / kGranularity; }
+
+  void reserveBlock();
+
+  /// An entry of a free list, stored inside the freed memory itself.
+  struct FreeNode {
+    FreeNode* next;
+  };
+
+  char* m_cursor;
+  char* m_end;
+  FreeNode* m_freeLists[kMaxSmallSize / kGranularity + 1];
+  std::vector<void*> m_blocks;
+  ArenaStats m_stats;
+
+  static Arena* s_runArena;
+};
+
+/// \brief A standard library allocator backed by an Arena.
+///     A default constructed allocator binds to the run arena if it is
+///     enabled, and to the global heap otherwise, so containers using it
+///     behave like ordinary containers when the arena is turned off.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  ArenaAllocator() : m_arena(Arena::GetRunArena()) {}
+  explicit ArenaAllocator(Arena* arena) : m_arena(arena) {}
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.m_arena) {}
+
+  T* allocate(size_t n) {
+    if (m_arena == nullptr) return static_cast<T*>(::operator new(n * sizeof(T)));
+    return static_cast<T*>(m_arena->Allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    if (m_arena == nullptr) {
+      ::operator delete(ptr);
+      return;
+    }
+    m_arena->Deallocate(ptr, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const {
+    return m_arena == other.m_arena;
+  }
+
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const {
+    return m_arena != other.m_arena;
+  }
+
+ private:
+  template <typename U>
+  friend class ArenaAllocator;
+
+  Arena* m_arena;
+};
+
+}  // namespace rhpman
+
+#endif
@@ -0,0 +1,86 @@
+/// \file bulk-transfer.cc
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#include <algorithm>
+#include <iterator>
+
+#include "bulk-transfer.h"
+
+namespace rhpman {
+
+FragmentReceiver::FragmentReceiver(uint32_t fragments)
+    : m_fragments(fragments), m_end(0), m_missing() {}
+
+bool FragmentReceiver::Receive(uint32_t index) {
+  if (index >= m_fragments) return false;
+  if (index < m_end) return m_missing.Remove(index);
+  for (uint32_t skipped = m_end; skipped < index; skipped++) {
+    m_missing.Add(skipped);
+  }
+  m_end = index + 1;
+  return true;
+}
+
+FragmentSender::FragmentSender(uint32_t fragments, uint32_t window)
+    : m_fragments(fragments),
+      m_window(std::max<uint32_t>(window, 1)),
+      m_next(0),
+      m_end(0),
+      m_missing(),
+      m_inFlight(),
+      m_repaired() {}
+
+bool FragmentSender::isReceived(uint32_t index) const {
+  return index < m_end && !m_missing.Contains(index);
+}
+
+/// A recipient which resumes a transfer may report fragments which were
+/// never sent in this one, so the window skips over those. Fragments reported
+/// missing which the window has not reached yet are simply sent when it does.
+bool FragmentSender::ReceiveStatus(
+    uint32_t end,
+    const DataSet& missing,
+    std::vector<uint32_t>& send) {
+  if (end < m_end) return false;
+  m_end = std::min(end, m_fragments);
+  m_missing = missing;
+  for (auto i = m_inFlight.begin(); i != m_inFlight.end();) {
+    i = isReceived(*i) ? m_inFlight.erase(i) : std::next(i);
+  }
+  for (uint32_t index : m_missing) {
+    if (index >= m_next) break;
+    if (m_repaired.insert(index).second) send.push_back(index);
+  }
+  return true;
+}
+
+void FragmentSender::Advance(std::vector<uint32_t>& send) {
+  while (m_inFlight.size() < m_window && m_next < m_fragments) {
+    if (!isReceived(m_next)) {
+      m_inFlight.insert(m_next);
+      send.push_back(m_next);
+    }
+    m_next++;
+  }
+}
+
+void FragmentSender::Reset() {
+  if (!m_inFlight.empty()) m_next = std::min(m_next, *m_inFlight.begin());
+  m_inFlight.clear();
+  m_repaired.clear();
+}
+
+}  // namespace rhpman
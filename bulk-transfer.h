@@ -0,0 +1,104 @@
+/// \file bulk-transfer.h
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+/// \brief Declares the state kept at each end of a transfer of a data item
+///     which is split into fragments.
+///
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef __bulk_transfer_h
+#define __bulk_transfer_h
+
+#include <inttypes.h>
+#include <set>
+#include <vector>
+
+#include "data-set.h"
+
+namespace rhpman {
+
+/// \brief What the recipient of a transfer has received: every fragment
+///     before GetEnd(), except those in GetMissing(). Fragments may come from
+///     any number of senders, and over any number of contacts.
+class FragmentReceiver {
+ public:
+  explicit FragmentReceiver(uint32_t fragments = 0);
+
+  uint32_t GetFragments() const { return m_fragments; }
+  /// \brief Gets one past the last fragment received.
+  uint32_t GetEnd() const { return m_end; }
+  /// \brief Gets the fragments before GetEnd() which were not received.
+  const DataSet& GetMissing() const { return m_missing; }
+  bool IsComplete() const { return m_end == m_fragments && m_missing.IsEmpty(); }
+
+  /// \return bool True if the fragment was not received before.
+  bool Receive(uint32_t index);
+
+ private:
+  uint32_t m_fragments;
+  uint32_t m_end;
+  DataSet m_missing;
+};
+
+/// \brief The sending end of a transfer: a selective repeat window over the
+///     fragments of an item. At most a window of fragments are in flight,
+///     that is, sent and not reported as received by the recipient. Those
+///     the recipient reports as missing are sent again once per report, and
+///     everything in flight is sent again after a timeout.
+class FragmentSender {
+ public:
+  FragmentSender(uint32_t fragments = 0, uint32_t window = 1);
+
+  uint32_t GetFragments() const { return m_fragments; }
+  bool IsComplete() const { return m_end == m_fragments && m_missing.IsEmpty(); }
+  /// \brief The number of fragments which the recipient has not reported
+  ///     receiving yet.
+  uint32_t GetUnacknowledged() const { return m_fragments - m_end + m_missing.GetSize(); }
+
+  /// \brief Applies a status report from the recipient.
+  ///
+  /// \param end One past the last fragment the recipient received.
+  /// \param missing The fragments before end which the recipient lacks.
+  /// \param send Receives the fragments to send again.
+  /// \return bool False if the report is older than one already applied.
+  bool ReceiveStatus(uint32_t end, const DataSet& missing, std::vector<uint32_t>& send);
+
+  /// \brief Takes new fragments to send, as many as fit in the window.
+  ///
+  /// \param send Receives the fragments to send.
+  void Advance(std::vector<uint32_t>& send);
+
+  /// \brief Sends everything in flight again, once the recipient next
+  ///     reports its status. Called when the recipient stopped answering.
+  void Reset();
+
+ private:
+  bool isReceived(uint32_t index) const;
+
+  uint32_t m_fragments;
+  uint32_t m_window;
+  // The next fragment to consider sending.
+  uint32_t m_next;
+  // The last status report.
+  uint32_t m_end;
+  DataSet m_missing;
+  // Fragments in flight, and those sent again since the last reset.
+  std::set<uint32_t> m_inFlight;
+  std::set<uint32_t> m_repaired;
+};
+
+}  // namespace rhpman
+
+#endif
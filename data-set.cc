@@ -0,0 +1,391 @@
+/// \file data-set.cc
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#include <inttypes.h>
+#include <algorithm>
+
+#include "ns3/buffer.h"
+
+#include "data-set.h"
+#include "messages.h"
+
+namespace rhpman {
+
+namespace {
+
+constexpr uint32_t kBitmapWords = 65536 / 64;
+
+// Ways a container is serialized.
+constexpr uint8_t kArrayEncoding = 0;
+constexpr uint8_t kBitmapEncoding = 1;
+
+uint32_t countBits(const uint64_t* words) {
+  uint32_t count = 0;
+  for (uint32_t w = 0; w < kBitmapWords; w++) count += __builtin_popcountll(words[w]);
+  return count;
+}
+
+}  // namespace
+
+bool DataSet::Container::Contains(uint16_t low) const {
+  if (IsBitmap()) return (bitmap[low / 64] >> (low % 64)) & 1;
+  return std::binary_search(array.begin(), array.end(), low);
+}
+
+bool DataSet::Container::Add(uint16_t low) {
+  if (IsBitmap()) {
+    const uint64_t bit = uint64_t(1) << (low % 64);
+    if (bitmap[low / 64] & bit) return false;
+    bitmap[low / 64] |= bit;
+    cardinality++;
+    return true;
+  }
+  auto position = std::lower_bound(array.begin(), array.end(), low);
+  if (position != array.end() && *position == low) return false;
+  array.insert(position, low);
+  cardinality++;
+  if (cardinality > kArrayLimit) ToBitmap();
+  return true;
+}
+
+bool DataSet::Container::Remove(uint16_t low) {
+  if (IsBitmap()) {
+    const uint64_t bit = uint64_t(1) << (low % 64);
+    if (!(bitmap[low / 64] & bit)) return false;
+    bitmap[low / 64] &= ~bit;
+    cardinality--;
+    if (cardinality <= kArrayLimit) ToArray();
+    return true;
+  }
+  auto position = std::lower_bound(array.begin(), array.end(), low);
+  if (position == array.end() || *position != low) return false;
+  array.erase(position);
+  cardinality--;
+  return true;
+}
+
+void DataSet::Container::ToBitmap() {
+  bitmap.assign(kBitmapWords, 0);
+  for (uint16_t low : array) bitmap[low / 64] |= uint64_t(1) << (low % 64);
+  array.clear();
+  array.shrink_to_fit();
+}
+
+void DataSet::Container::ToArray() {
+  std::vector<uint16_t, ArenaAllocator<uint16_t>> lows;
+  lows.reserve(cardinality);
+  ForEach([&lows](uint16_t low) { lows.push_back(low); });
+  array.swap(lows);
+  bitmap.clear();
+  bitmap.shrink_to_fit();
+}
+
+/// Recounts a container after a set operation, and converts it to the
+/// representation its new cardinality calls for.
+void DataSet::Container::Normalize() {
+  if (IsBitmap()) {
+    cardinality = countBits(bitmap.data());
+    if (cardinality <= kArrayLimit) ToArray();
+  } else {
+    cardinality = array.size();
+    if (cardinality > kArrayLimit) ToBitmap();
+  }
+}
+
+uint32_t DataSet::Container::GetArraySerializedSize() const {
+  uint32_t size = GetVarintSize(cardinality);
+  uint32_t previous = 0;
+  ForEach([&](uint32_t low) {
+    size += GetVarintSize(low - previous);
+    previous = low;
+  });
+  return size;
+}
+
+DataSet::Containers::iterator DataSet::lowerBound(uint16_t key) {
+  return std::lower_bound(
+      m_containers.begin(),
+      m_containers.end(),
+      key,
+      [](const Container& container, uint16_t key) { return container.key < key; });
+}
+
+DataSet::Containers::const_iterator DataSet::lowerBound(uint16_t key) const {
+  return std::lower_bound(
+      m_containers.begin(),
+      m_containers.end(),
+      key,
+      [](const Container& container, uint16_t key) { return container.key < key; });
+}
+
+bool DataSet::Contains(uint32_t id) const {
+  auto found = lowerBound(id >> 16);
+  return found != m_containers.end() && found->key == (id >> 16) && found->Contains(id & 0xffff);
+}
+
+bool DataSet::Add(uint32_t id) {
+  auto found = lowerBound(id >> 16);
+  if (found == m_containers.end() || found->key != (id >> 16)) {
+    found = m_containers.insert(found, Container());
+    found->key = id >> 16;
+    found->cardinality = 0;
+  }
+  if (!found->Add(id & 0xffff)) return false;
+  m_size++;
+  return true;
+}
+
+bool DataSet::Remove(uint32_t id) {
+  auto found = lowerBound(id >> 16);
+  if (found == m_containers.end() || found->key != (id >> 16)) return false;
+  if (!found->Remove(id & 0xffff)) return false;
+  if (found->cardinality == 0) m_containers.erase(found);
+  m_size--;
+  return true;
+}
+
+void DataSet::Clear() {
+  m_containers.clear();
+  m_size = 0;
+}
+
+void DataSet::Swap(DataSet& other) {
+  m_containers.swap(other.m_containers);
+  std::swap(m_size, other.m_size);
+}
+
+void DataSet::UnionWith(const DataSet& other) {
+  Containers result;
+  result.reserve(m_containers.size() + other.m_containers.size());
+  auto a = m_containers.begin();
+  auto b = other.m_containers.begin();
+  while (a != m_containers.end() || b != other.m_containers.end()) {
+    if (b == other.m_containers.end() || (a != m_containers.end() && a->key < b->key)) {
+      result.push_back(std::move(*a++));
+      continue;
+    }
+    if (a == m_containers.end() || b->key < a->key) {
+      result.push_back(*b++);
+      continue;
+    }
+    Container& merged = *a;
+    if (merged.IsBitmap() || b->IsBitmap()) {
+      if (!merged.IsBitmap()) merged.ToBitmap();
+      if (b->IsBitmap()) {
+        for (uint32_t w = 0; w < kBitmapWords; w++) merged.bitmap[w] |= b->bitmap[w];
+      } else {
+        for (uint16_t low : b->array) merged.bitmap[low / 64] |= uint64_t(1) << (low % 64);
+      }
+    } else {
+      decltype(merged.array) array;
+      array.reserve(merged.array.size() + b->array.size());
+      std::set_union(
+          merged.array.begin(),
+          merged.array.end(),
+          b->array.begin(),
+          b->array.end(),
+          std::back_inserter(array));
+      merged.array.swap(array);
+    }
+    merged.Normalize();
+    result.push_back(std::move(merged));
+    ++a;
+    ++b;
+  }
+  m_containers.swap(result);
+  recount();
+}
+
+void DataSet::IntersectWith(const DataSet& other) {
+  Containers result;
+  auto b = other.m_containers.begin();
+  for (Container& container : m_containers) {
+    while (b != other.m_containers.end() && b->key < container.key) ++b;
+    if (b == other.m_containers.end()) break;
+    if (b->key != container.key) continue;
+    if (container.IsBitmap() && b->IsBitmap()) {
+      for (uint32_t w = 0; w < kBitmapWords; w++) container.bitmap[w] &= b->bitmap[w];
+    } else if (container.IsBitmap()) {
+      for (uint16_t low : b->array) {
+        if (container.Contains(low)) container.array.push_back(low);
+      }
+      container.bitmap.clear();
+    } else {
+      const Container& filter = *b;
+      container.array.erase(
+          std::remove_if(
+              container.array.begin(),
+              container.array.end(),
+              [&filter](uint16_t low) { return !filter.Contains(low); }),
+          container.array.end());
+    }
+    container.Normalize();
+    if (container.cardinality > 0) result.push_back(std::move(container));
+  }
+  m_containers.swap(result);
+  recount();
+}
+
+void DataSet::Subtract(const DataSet& other) {
+  Containers result;
+  auto b = other.m_containers.begin();
+  for (Container& container : m_containers) {
+    while (b != other.m_containers.end() && b->key < container.key) ++b;
+    if (b != other.m_containers.end() && b->key == container.key) {
+      if (container.IsBitmap() && b->IsBitmap()) {
+        for (uint32_t w = 0; w < kBitmapWords; w++) container.bitmap[w] &= ~b->bitmap[w];
+      } else if (container.IsBitmap()) {
+        for (uint16_t low : b->array) {
+          container.bitmap[low / 64] &= ~(uint64_t(1) << (low % 64));
+        }
+      } else {
+        const Container& filter = *b;
+        container.array.erase(
+            std::remove_if(
+                container.array.begin(),
+                container.array.end(),
+                [&filter](uint16_t low) { return filter.Contains(low); }),
+            container.array.end());
+      }
+      container.Normalize();
+    }
+    if (container.cardinality > 0) result.push_back(std::move(container));
+  }
+  m_containers.swap(result);
+  recount();
+}
+
+void DataSet::recount() {
+  m_size = 0;
+  for (const Container& container : m_containers) m_size += container.cardinality;
+}
+
+size_t DataSet::GetMemory() const {
+  size_t memory = m_containers.capacity() * sizeof(Container);
+  for (const Container& container : m_containers) {
+    memory += container.array.capacity() * sizeof(uint16_t);
+    memory += container.bitmap.capacity() * sizeof(uint64_t);
+  }
+  return memory;
+}
+
+uint32_t DataSet::GetSerializedSize() const {
+  uint32_t size = GetVarintSize(m_containers.size());
+  uint16_t previous = 0;
+  for (const Container& container : m_containers) {
+    size += GetVarintSize(container.key - previous) + 1;
+    size += std::min(container.GetArraySerializedSize(), kBitmapWords * 8);
+    previous = container.key;
+  }
+  return size;
+}
+
+void DataSet::Serialize(Buffer::Iterator& i) const {
+  WriteVarint(i, m_containers.size());
+  uint16_t previous = 0;
+  for (const Container& container : m_containers) {
+    WriteVarint(i, container.key - previous);
+    previous = container.key;
+    if (container.GetArraySerializedSize() >= kBitmapWords * 8) {
+      i.WriteU8(kBitmapEncoding);
+      if (container.IsBitmap()) {
+        for (uint64_t word : container.bitmap) i.WriteU64(word);
+      } else {
+        Container bitmap = container;
+        bitmap.ToBitmap();
+        for (uint64_t word : bitmap.bitmap) i.WriteU64(word);
+      }
+      continue;
+    }
+    i.WriteU8(kArrayEncoding);
+    WriteVarint(i, container.cardinality);
+    uint32_t previous = 0;
+    container.ForEach([&i, &previous](uint32_t low) {
+      WriteVarint(i, low - previous);
+      previous = low;
+    });
+  }
+}
+
+void DataSet::Deserialize(Buffer::Iterator& i) {
+  Clear();
+  const uint32_t containers = ReadVarint(i);
+  uint16_t key = 0;
+  for (uint32_t c = 0; c < containers; c++) {
+    key += ReadVarint(i);
+    Container container;
+    container.key = key;
+    container.cardinality = 0;
+    if (i.ReadU8() == kBitmapEncoding) {
+      container.bitmap.resize(kBitmapWords);
+      for (uint64_t& word : container.bitmap) word = i.ReadU64();
+    } else {
+      const uint32_t cardinality = ReadVarint(i);
+      container.array.reserve(cardinality);
+      uint32_t low = 0;
+      for (uint32_t n = 0; n < cardinality; n++) {
+        low += ReadVarint(i);
+        container.array.push_back(low);
+      }
+    }
+    container.Normalize();
+    if (container.cardinality > 0) m_containers.push_back(std::move(container));
+  }
+  recount();
+}
+
+bool DataSet::operator==(const DataSet& other) const {
+  return m_size == other.m_size && std::equal(begin(), end(), other.begin(), other.end());
+}
+
+DataSet::Iterator::Iterator(const DataSet* set, size_t container)
+    : m_set(set), m_container(container), m_position(0), m_id(0) {
+  seek();
+}
+
+DataSet::Iterator& DataSet::Iterator::operator++() {
+  m_position++;
+  seek();
+  return *this;
+}
+
+/// Moves to the first id at or after the current position.
+void DataSet::Iterator::seek() {
+  const Containers& containers = m_set->m_containers;
+  for (; m_container < containers.size(); m_container++, m_position = 0) {
+    const Container& container = containers[m_container];
+    const uint32_t high = uint32_t(container.key) << 16;
+    if (!container.IsBitmap()) {
+      if (m_position < container.array.size()) {
+        m_id = high | container.array[m_position];
+        return;
+      }
+      continue;
+    }
+    uint32_t w = m_position / 64;
+    if (w >= kBitmapWords) continue;
+    uint64_t word = container.bitmap[w] & (~uint64_t(0) << (m_position % 64));
+    while (word == 0 && ++w < kBitmapWords) word = container.bitmap[w];
+    if (word != 0) {
+      m_position = w * 64 + __builtin_ctzll(word);
+      m_id = high | m_position;
+      return;
+    }
+  }
+  m_position = 0;
+}
+
+}  // namespace rhpman
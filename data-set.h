@@ -0,0 +1,168 @@
+/// \file data-set.h
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+/// \brief Declares a compressed set of data item ids, used to hold the data
+///     stored by a node.
+///
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef __data_set_h
+#define __data_set_h
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <iterator>
+#include <vector>
+
+#include "ns3/buffer.h"
+
+#include "arena.h"
+
+namespace rhpman {
+
+using namespace ns3;
+
+/// \brief A set of 32-bit data ids, stored as a compressed bitmap in the
+///     manner of Roaring bitmaps.
+///     Ids are grouped by their upper 16 bits into containers, kept sorted by
+///     key. A container with at most kArrayLimit ids holds their lower 16
+///     bits in a sorted array; a fuller one holds a 65536-bit bitmap. Either
+///     way a container never takes more than 8 KiB, membership is a binary
+///     search over containers followed by a search or a bit test, and set
+///     operations work on whole containers at a time.
+///     Ids are iterated in increasing order.
+class DataSet {
+ public:
+  /// Largest number of ids held by an array container.
+  static constexpr uint32_t kArrayLimit = 4096;
+
+  DataSet() : m_containers(), m_size(0) {}
+
+  size_t GetSize() const { return m_size; }
+  bool IsEmpty() const { return m_size == 0; }
+
+  bool Contains(uint32_t id) const;
+
+  /// \return bool True if the id was not in the set yet.
+  bool Add(uint32_t id);
+
+  /// \return bool True if the id was in the set.
+  bool Remove(uint32_t id);
+
+  void Clear();
+
+  /// \brief Exchanges the ids of two sets. Unlike Clear, swapping with an
+  ///     empty set frees all memory held by the set.
+  void Swap(DataSet& other);
+
+  /// \brief Adds every id of another set to this set.
+  void UnionWith(const DataSet& other);
+
+  /// \brief Removes every id which is not in another set from this set.
+  void IntersectWith(const DataSet& other);
+
+  /// \brief Removes every id of another set from this set.
+  void Subtract(const DataSet& other);
+
+  /// \brief Gets the number of bytes used by the containers of the set.
+  size_t GetMemory() const;
+
+  /// \brief Gets the size of the set when serialized; each container is
+  ///     written as gap-coded varints or as a bitmap, whichever is smaller.
+  uint32_t GetSerializedSize() const;
+  void Serialize(Buffer::Iterator& i) const;
+  void Deserialize(Buffer::Iterator& i);
+
+  bool operator==(const DataSet& other) const;
+  bool operator!=(const DataSet& other) const { return !(*this == other); }
+
+ private:
+  struct Container {
+    uint16_t key;
+    uint32_t cardinality;
+    // Exactly one of these is used; the bitmap when cardinality is above
+    // kArrayLimit.
+    std::vector<uint16_t, ArenaAllocator<uint16_t>> array;
+    std::vector<uint64_t, ArenaAllocator<uint64_t>> bitmap;
+
+    bool IsBitmap() const { return !bitmap.empty(); }
+    bool Contains(uint16_t low) const;
+    bool Add(uint16_t low);
+    bool Remove(uint16_t low);
+    void ToBitmap();
+    void ToArray();
+    void Normalize();
+    uint32_t GetArraySerializedSize() const;
+
+    /// Calls f with the lower 16 bits of each id, in increasing order.
+    template <typename F>
+    void ForEach(F f) const {
+      if (!IsBitmap()) {
+        for (uint16_t low : array) f(low);
+        return;
+      }
+      for (uint32_t w = 0; w < bitmap.size(); w++) {
+        for (uint64_t word = bitmap[w]; word != 0; word &= word - 1) {
+          f(w * 64 + __builtin_ctzll(word));
+        }
+      }
+    }
+  };
+
+ public:
+  /// \brief Iterates the ids of a set in increasing order.
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = uint32_t;
+    using difference_type = ptrdiff_t;
+    using pointer = const uint32_t*;
+    using reference = uint32_t;
+
+    Iterator(const DataSet* set, size_t container);
+
+    uint32_t operator*() const { return m_id; }
+    Iterator& operator++();
+    bool operator==(const Iterator& other) const {
+      return m_container == other.m_container && m_position == other.m_position;
+    }
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+   private:
+    void seek();
+
+    const DataSet* m_set;
+    size_t m_container;
+    uint32_t m_position;
+    uint32_t m_id;
+  };
+
+  Iterator begin() const { return Iterator(this, 0); }
+  Iterator end() const { return Iterator(this, m_containers.size()); }
+
+ private:
+  using Containers = std::vector<Container, ArenaAllocator<Container>>;
+
+  Containers::iterator lowerBound(uint16_t key);
+  Containers::const_iterator lowerBound(uint16_t key) const;
+  void recount();
+
+  Containers m_containers;
+  size_t m_size;
+};
+
+}  // namespace rhpman
+
+#endif
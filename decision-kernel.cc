@@ -0,0 +1,131 @@
+/// \file decision-kernel.cc
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#include <inttypes.h>
+#include <algorithm>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RHPMAN_X86 1
+#endif
+
+#include "decision-kernel.h"
+
+namespace rhpman {
+
+void DecisionMasks::Reset(uint32_t neighbors, uint32_t items) {
+  m_words = (items + 63) / 64;
+  m_forward.assign(size_t(neighbors) * m_words, 0);
+  m_carry.assign(size_t(neighbors) * m_words, 0);
+}
+
+void ComputeDecisionsScalar(const DecisionInputs& in, DecisionMasks& out) {
+  out.Reset(in.neighbors, in.items);
+  for (uint32_t m = 0; m < in.neighbors; m++) {
+    const float base = in.wcdc * in.degreeConnectivity[m];
+    const float* colocation = in.colocation + size_t(m) * in.partitions;
+    uint64_t* forward = out.ForwardRow(m);
+    uint64_t* carry = out.CarryRow(m);
+    for (uint32_t k = 0; k < in.items; k++) {
+      const float p = base + in.wcol * colocation[in.home[k]];
+      forward[k / 64] |= uint64_t(p > in.forwardingThreshold) << (k % 64);
+      carry[k / 64] |= uint64_t(p > in.carryingThreshold) << (k % 64);
+    }
+  }
+}
+
+#ifdef RHPMAN_X86
+
+namespace {
+
+// The probability of a pair only depends on the neighbor and the home
+// partition of the item. So for each neighbor, the decisions are first made
+// once per partition, 4 partitions at a time, giving a byte lookup table of
+// 0x00 or 0xff per partition. With at most 16 partitions, the table fits in a
+// single register, and pshufb then looks up the decisions of 16 items at once.
+__attribute__((target("ssse3"))) void computeDecisionsSsse3(
+    const DecisionInputs& in,
+    DecisionMasks& out) {
+  out.Reset(in.neighbors, in.items);
+  alignas(16) uint8_t forwardTable[256 + 4];
+  alignas(16) uint8_t carryTable[256 + 4];
+  alignas(16) int32_t lanes[4];
+
+  const __m128 wcol = _mm_set1_ps(in.wcol);
+  const __m128 sigma = _mm_set1_ps(in.forwardingThreshold);
+  const __m128 tau = _mm_set1_ps(in.carryingThreshold);
+
+  for (uint32_t m = 0; m < in.neighbors; m++) {
+    const float base = in.wcdc * in.degreeConnectivity[m];
+    const __m128 baseV = _mm_set1_ps(base);
+    const float* colocation = in.colocation + size_t(m) * in.partitions;
+
+    uint32_t p = 0;
+    for (; p + 4 <= in.partitions; p += 4) {
+      const __m128 prob = _mm_add_ps(baseV, _mm_mul_ps(wcol, _mm_loadu_ps(colocation + p)));
+      _mm_store_si128(
+          reinterpret_cast<__m128i*>(lanes),
+          _mm_castps_si128(_mm_cmpgt_ps(prob, sigma)));
+      for (int l = 0; l < 4; l++) forwardTable[p + l] = lanes[l];
+      _mm_store_si128(
+          reinterpret_cast<__m128i*>(lanes),
+          _mm_castps_si128(_mm_cmpgt_ps(prob, tau)));
+      for (int l = 0; l < 4; l++) carryTable[p + l] = lanes[l];
+    }
+    for (; p < in.partitions; p++) {
+      const float prob = base + in.wcol * colocation[p];
+      forwardTable[p] = prob > in.forwardingThreshold ? 0xff : 0;
+      carryTable[p] = prob > in.carryingThreshold ? 0xff : 0;
+    }
+
+    uint64_t* forward = out.ForwardRow(m);
+    uint64_t* carry = out.CarryRow(m);
+    uint32_t k = 0;
+    if (in.partitions <= 16) {
+      const __m128i forwardLut = _mm_load_si128(reinterpret_cast<const __m128i*>(forwardTable));
+      const __m128i carryLut = _mm_load_si128(reinterpret_cast<const __m128i*>(carryTable));
+      for (; k + 16 <= in.items; k += 16) {
+        const __m128i home = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in.home + k));
+        const uint64_t f = uint16_t(_mm_movemask_epi8(_mm_shuffle_epi8(forwardLut, home)));
+        const uint64_t c = uint16_t(_mm_movemask_epi8(_mm_shuffle_epi8(carryLut, home)));
+        forward[k / 64] |= f << (k % 64);
+        carry[k / 64] |= c << (k % 64);
+      }
+    }
+    for (; k < in.items; k++) {
+      forward[k / 64] |= uint64_t(forwardTable[in.home[k]] & 1) << (k % 64);
+      carry[k / 64] |= uint64_t(carryTable[in.home[k]] & 1) << (k % 64);
+    }
+  }
+}
+
+}  // namespace
+
+#endif
+
+void ComputeDecisions(const DecisionInputs& in, DecisionMasks& out) {
+#ifdef RHPMAN_X86
+  static const bool ssse3 = __builtin_cpu_supports("ssse3");
+  if (ssse3) {
+    computeDecisionsSsse3(in, out);
+    return;
+  }
+#endif
+  ComputeDecisionsScalar(in, out);
+}
+
+}  // namespace rhpman
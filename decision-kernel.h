@@ -0,0 +1,101 @@
+/// \file decision-kernel.h
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+/// \brief Declares a batch kernel which makes the RHPMAN forwarding and
+///     carrying decisions of a node for all of its neighbors and data items.
+///
+///     The delivery probability of neighbor n for data item d is
+///         P(n, d) = w_cdc * cdc(n) + w_col * col(n, home(d))
+///     where home(d) is the partition the item belongs to. Data is forwarded
+///     to n if P(n, d) > sigma, and carried by n if P(n, d) > tau.
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef __decision_kernel_h
+#define __decision_kernel_h
+
+#include <inttypes.h>
+#include <vector>
+
+namespace rhpman {
+
+/// \brief Struct-of-arrays inputs of the decision kernel for one node.
+struct DecisionInputs {
+  /// Number of neighbors (M).
+  uint32_t neighbors;
+  /// Number of partitions (P); at most 256.
+  uint32_t partitions;
+  /// Number of data items (K).
+  uint32_t items;
+  /// Change in degree of connectivity of each neighbor; M values.
+  const float* degreeConnectivity;
+  /// Colocation of each neighbor with each partition; M rows of P values.
+  const float* colocation;
+  /// Home partition of each data item; K values.
+  const uint8_t* home;
+  /// Weight of degree connectivity (w_cdc).
+  float wcdc;
+  /// Weight of colocation (w_col).
+  float wcol;
+  /// Forwarding threshold (sigma).
+  float forwardingThreshold;
+  /// Carrying threshold (tau).
+  float carryingThreshold;
+};
+
+/// \brief Forwarding and carrying decisions for every (neighbor, item) pair.
+///     Each neighbor has a row of GetWords() 64-bit words, where bit k of the
+///     row is the decision for item k.
+class DecisionMasks {
+ public:
+  DecisionMasks() : m_words(0), m_forward(), m_carry() {}
+
+  /// \brief Resizes the masks for M neighbors and K items, clearing all bits.
+  void Reset(uint32_t neighbors, uint32_t items);
+
+  uint32_t GetWords() const { return m_words; }
+
+  bool Forward(uint32_t neighbor, uint32_t item) const {
+    return (m_forward[neighbor * m_words + item / 64] >> (item % 64)) & 1;
+  }
+  bool Carry(uint32_t neighbor, uint32_t item) const {
+    return (m_carry[neighbor * m_words + item / 64] >> (item % 64)) & 1;
+  }
+
+  uint64_t* ForwardRow(uint32_t neighbor) { return m_forward.data() + neighbor * m_words; }
+  uint64_t* CarryRow(uint32_t neighbor) { return m_carry.data() + neighbor * m_words; }
+  const uint64_t* ForwardRow(uint32_t neighbor) const {
+    return m_forward.data() + neighbor * m_words;
+  }
+  const uint64_t* CarryRow(uint32_t neighbor) const { return m_carry.data() + neighbor * m_words; }
+
+ private:
+  uint32_t m_words;
+  std::vector<uint64_t> m_forward;
+  std::vector<uint64_t> m_carry;
+};
+
+/// \brief Makes the decisions for all (neighbor, item) pairs of a node.
+///     Uses SIMD instructions when the processor supports them, and gives the
+///     same results as ComputeDecisionsScalar in every case.
+///
+/// \param in The inputs of the kernel.
+/// \param out The decisions; resized to fit the inputs.
+void ComputeDecisions(const DecisionInputs& in, DecisionMasks& out);
+
+/// \brief Portable reference implementation of ComputeDecisions.
+void ComputeDecisionsScalar(const DecisionInputs& in, DecisionMasks& out);
+
+}  // namespace rhpman
+
+#endif
@@ -0,0 +1,144 @@
+/// \file iblt.cc
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#include <inttypes.h>
+#include <algorithm>
+
+#include "ns3/buffer.h"
+
+#include "iblt.h"
+#include "messages.h"
+
+namespace rhpman {
+
+namespace {
+
+// Counts are small and signed, so they are zigzag encoded before being
+// written as varints.
+uint32_t zigzag(int32_t value) { return (uint32_t(value) << 1) ^ uint32_t(value >> 31); }
+
+int32_t unzigzag(uint32_t value) { return int32_t(value >> 1) ^ -int32_t(value & 1); }
+
+uint64_t mix(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+}  // namespace
+
+// static
+uint32_t Iblt::GetCellsFor(uint32_t difference) {
+  // Small differences peel less reliably, so every table gets some slack;
+  // about 1 in 100 tables then fails to decode.
+  return difference + difference / 2 + 8 * kHashes;
+}
+
+Iblt::Iblt(uint32_t cells) {
+  const uint32_t rounded = std::max<uint32_t>(1, (cells + kHashes - 1) / kHashes) * kHashes;
+  m_count.assign(rounded, 0);
+  m_idSum.assign(rounded, 0);
+  m_checkSum.assign(rounded, 0);
+}
+
+void Iblt::Subtract(const Iblt& other) {
+  NS_ASSERT(other.GetCells() == GetCells());
+  for (uint32_t c = 0; c < GetCells(); c++) {
+    m_count[c] -= other.m_count[c];
+    m_idSum[c] ^= other.m_idSum[c];
+    m_checkSum[c] ^= other.m_checkSum[c];
+  }
+}
+
+/// A cell is pure when it holds a single id, which its check sum confirms.
+/// Removing that id from its other cells may make them pure in turn.
+bool Iblt::Decode(std::vector<uint32_t>& added, std::vector<uint32_t>& removed) const {
+  Iblt table = *this;
+  std::vector<uint32_t> pure;
+  auto isPure = [&table](uint32_t c) {
+    return (table.m_count[c] == 1 || table.m_count[c] == -1) &&
+           table.m_checkSum[c] == check(table.m_idSum[c]);
+  };
+  for (uint32_t c = 0; c < GetCells(); c++) {
+    if (isPure(c)) pure.push_back(c);
+  }
+  while (!pure.empty()) {
+    const uint32_t c = pure.back();
+    pure.pop_back();
+    if (!isPure(c)) continue;
+    const uint32_t id = table.m_idSum[c];
+    const int32_t count = table.m_count[c];
+    (count > 0 ? added : removed).push_back(id);
+    table.update(id, -count);
+    for (uint32_t h = 0; h < kHashes; h++) {
+      const uint32_t cell = getCell(id, h);
+      if (isPure(cell)) pure.push_back(cell);
+    }
+  }
+  for (uint32_t c = 0; c < GetCells(); c++) {
+    if (table.m_count[c] != 0 || table.m_idSum[c] != 0 || table.m_checkSum[c] != 0) return false;
+  }
+  return true;
+}
+
+uint32_t Iblt::GetSerializedSize() const {
+  uint32_t size = GetVarintSize(GetCells());
+  for (uint32_t c = 0; c < GetCells(); c++) {
+    size += GetVarintSize(zigzag(m_count[c])) + 8;
+  }
+  return size;
+}
+
+void Iblt::Serialize(Buffer::Iterator& i) const {
+  WriteVarint(i, GetCells());
+  for (uint32_t c = 0; c < GetCells(); c++) {
+    WriteVarint(i, zigzag(m_count[c]));
+    i.WriteU32(m_idSum[c]);
+    i.WriteU32(m_checkSum[c]);
+  }
+}
+
+void Iblt::Deserialize(Buffer::Iterator& i) {
+  const uint32_t cells = ReadVarint(i);
+  m_count.resize(cells);
+  m_idSum.resize(cells);
+  m_checkSum.resize(cells);
+  for (uint32_t c = 0; c < cells; c++) {
+    m_count[c] = unzigzag(ReadVarint(i));
+    m_idSum[c] = i.ReadU32();
+    m_checkSum[c] = i.ReadU32();
+  }
+}
+
+void Iblt::update(uint32_t id, int32_t count) {
+  const uint32_t checkSum = check(id);
+  for (uint32_t h = 0; h < kHashes; h++) {
+    const uint32_t c = getCell(id, h);
+    m_count[c] += count;
+    m_idSum[c] ^= id;
+    m_checkSum[c] ^= checkSum;
+  }
+}
+
+uint32_t Iblt::getCell(uint32_t id, uint32_t hash) const {
+  const uint32_t subtable = GetCells() / kHashes;
+  return hash * subtable + mix(uint64_t(hash) << 32 | id) % subtable;
+}
+
+// static
+uint32_t Iblt::check(uint32_t id) { return mix(~uint64_t(id)) >> 32; }
+
+}  // namespace rhpman
@@ -0,0 +1,86 @@
+/// \file iblt.h
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+/// \brief Declares an invertible Bloom lookup table of data ids, used to find
+///     the difference between the storage of two nodes.
+///
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef __iblt_h
+#define __iblt_h
+
+#include <inttypes.h>
+#include <vector>
+
+#include "ns3/buffer.h"
+
+namespace rhpman {
+
+using namespace ns3;
+
+/// \brief An invertible Bloom lookup table (IBLT) of 32-bit ids.
+///     Each id is added to one cell in each of kHashes equal subtables. When
+///     the table of one set is subtracted from the table of another of the
+///     same size, the ids common to both cancel out, and the ids of the
+///     symmetric difference can be listed by repeatedly peeling cells which
+///     hold a single id. Peeling succeeds with high probability when there
+///     are at least 1.5 cells per id of the difference, whatever the size of
+///     the sets themselves.
+class Iblt {
+ public:
+  static constexpr uint32_t kHashes = 3;
+
+  /// \brief Gets the number of cells a table needs to decode a difference of
+  ///     the given number of ids with high probability.
+  static uint32_t GetCellsFor(uint32_t difference);
+
+  /// \param cells The number of cells; rounded up to a multiple of kHashes.
+  explicit Iblt(uint32_t cells = kHashes);
+
+  uint32_t GetCells() const { return m_count.size(); }
+
+  void Insert(uint32_t id) { update(id, 1); }
+  void Remove(uint32_t id) { update(id, -1); }
+
+  /// \brief Subtracts the table of another set from this one; both tables
+  ///     must have the same number of cells.
+  void Subtract(const Iblt& other);
+
+  /// \brief Lists the difference held by a subtracted table.
+  ///
+  /// \param added Receives the ids which were inserted into this table only.
+  /// \param removed Receives the ids which were inserted into the other table
+  ///     only.
+  /// \return bool False if the difference is too large for the table to be
+  ///     decoded; the lists are then incomplete.
+  bool Decode(std::vector<uint32_t>& added, std::vector<uint32_t>& removed) const;
+
+  uint32_t GetSerializedSize() const;
+  void Serialize(Buffer::Iterator& i) const;
+  void Deserialize(Buffer::Iterator& i);
+
+ private:
+  void update(uint32_t id, int32_t count);
+  uint32_t getCell(uint32_t id, uint32_t hash) const;
+  static uint32_t check(uint32_t id);
+
+  std::vector<int32_t> m_count;
+  std::vector<uint32_t> m_idSum;
+  std::vector<uint32_t> m_checkSum;
+};
+
+}  // namespace rhpman
+
+#endif
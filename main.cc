@@ -18,6 +18,11 @@
 /// PERFORMANCE OF THIS SOFTWARE.
 
 #include <sysexits.h>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
 
 #include "ns3/animation-interface.h"
 #include "ns3/aodv-helper.h"
@@ -46,6 +51,7 @@
 #include "ns3/wifi-standards.h"
 #include "ns3/yans-wifi-helper.h"
 
+#include "arena.h"
 #include "logging.h"
 #include "nsutil.h"
 #include "rhpman.h"
@@ -122,6 +128,43 @@ void setupPbNodes(const SimulationParameters& params, NodeContainer& nodes) {
   }
 }
 
+/// \brief Prints the replica holder election overhead of all RHPMAN apps.
+///
+/// \param apps The RHPMAN apps of the simulation.
+void printElectionStats(const ApplicationContainer& apps) {
+  uint64_t messages = 0;
+  uint64_t elections = 0;
+  Time convergence;
+  for (uint32_t i = 0; i < apps.GetN(); i++) {
+    Ptr<RhpmanApp> app = DynamicCast<RhpmanApp>(apps.Get(i));
+    messages += app->GetElectionMessages();
+    elections += app->GetElectionsHeld();
+    convergence += app->GetElectionConvergenceTime();
+  }
+  const double mean = elections == 0 ? 0.0 : convergence.GetSeconds() / elections;
+  NS_LOG_UNCOND("Election messages: " << messages << ", mean convergence: " << mean << " s");
+}
+
+/// \brief Flushes every output owned by the simulation and terminates the
+///     process without running Simulator::Destroy or any object destructors.
+///     Tearing down the object graph of a large simulation takes a long time
+///     and produces no results, so sweeps may skip it entirely.
+///
+/// \param anim The animation interface, which is destroyed here so that the
+///     trace file is completed and closed.
+/// \param ss Buffered neighbour output to print before exiting.
+[[noreturn]] void fastTeardown(
+    std::unique_ptr<AnimationInterface> anim,
+    const std::ostringstream& ss) {
+  anim.reset();
+  NS_LOG_UNCOND("Done.");
+  std::cout << ss.str() << std::endl;
+  std::cout.flush();
+  std::cerr.flush();
+  std::fflush(nullptr);
+  std::_Exit(EX_OK);
+}
+
 int main(int argc, char* argv[]) {
   Time::SetResolution(Time::NS);
 
@@ -133,6 +176,9 @@ int main(int argc, char* argv[]) {
 
   /* Create nodes, network topology, and start simulation. */
   RngSeedManager::SetSeed(params.seed);
+  if (params.useArena) {
+    Arena::EnableRunArena();
+  }
   NodeContainer allAdHocNodes;
   NS_LOG_DEBUG("Simulation running over area: " << params.area);
 
@@ -170,7 +216,13 @@ int main(int argc, char* argv[]) {
 
   NS_LOG_UNCOND("Assigning MAC addresses in ad-hoc mode...");
   auto adhocDevices = wifi.Install(wifiPhy, wifiMac, allAdHocNodes);
-  wifiPhy.EnablePcap("rhpman", adhocDevices);
+  if (params.fastTeardown) {
+    // Pcap writers are owned by the trace sources of each device and are only
+    // flushed when the devices are destroyed, which fast teardown skips.
+    NS_LOG_UNCOND("Fast teardown enabled; pcap tracing is disabled.");
+  } else {
+    wifiPhy.EnablePcap("rhpman", adhocDevices);
+  }
 
   NS_LOG_UNCOND("Setting up Internet stacks...");
   InternetStackHelper internet;
@@ -200,15 +252,57 @@ int main(int argc, char* argv[]) {
   rhpman.SetAttribute("ColocationWeight", DoubleValue(params.wcol));
   rhpman.SetAttribute("DegreeConnectivityWeight", DoubleValue(params.wcdc));
   rhpman.SetAttribute("ProfileUpdateDelay", TimeValue(params.profileUpdateDelay));
+  rhpman.SetAttribute("AggregateProfiles", BooleanValue(params.aggregateProfiles));
+  rhpman.SetAttribute("AdaptiveProfileDelay", BooleanValue(params.adaptiveProfileDelay));
+  rhpman.SetAttribute("MaxProfileDelay", TimeValue(params.maxProfileDelay));
+  rhpman.SetAttribute("StartJitter", TimeValue(params.startJitter));
+  rhpman.SetAttribute("BroadcastJitter", TimeValue(params.broadcastJitter));
+  rhpman.SetAttribute("RebroadcastThreshold", UintegerValue(params.rebroadcastThreshold));
+  rhpman.SetAttribute("ElectionPeriod", TimeValue(params.electionPeriod));
+  rhpman.SetAttribute("ElectionBackoff", TimeValue(params.electionBackoff));
+  rhpman.SetAttribute("ElectionTimeout", TimeValue(params.electionTimeout));
+  rhpman.SetAttribute("ReconcileOnContact", BooleanValue(params.reconcile));
+  rhpman.SetAttribute("StorageCapacity", UintegerValue(params.storageCapacity));
+  rhpman.SetAttribute("ReplicaTtl", TimeValue(params.replicaTtl));
+  rhpman.SetAttribute("MaxTransfersPerTick", UintegerValue(params.maxTransfersPerTick));
+  rhpman.SetAttribute("AntiPackets", BooleanValue(params.antiPackets));
+  rhpman.SetAttribute("MaxBatchSize", UintegerValue(params.maxBatchSize));
+  rhpman.SetAttribute("BatchDelay", TimeValue(params.batchDelay));
+  rhpman.SetAttribute("DataSize", UintegerValue(params.dataSize));
+  rhpman.SetAttribute("FragmentSize", UintegerValue(params.fragmentSize));
+  rhpman.SetAttribute("TransferWindow", UintegerValue(params.transferWindow));
+  rhpman.SetAttribute("ContactAwareScheduling", BooleanValue(params.contactAware));
+  rhpman.SetAttribute("ContactRadius", DoubleValue(params.wifiRadius));
+  rhpman.SetAttribute("WorkerThreads", UintegerValue(params.workerThreads));
+  rhpman.SetArea(params.area, params.rows, params.cols);
   rhpman.SetDataOwners(params.dataOwners);
-  rhpman.Install(allAdHocNodes);
+  ApplicationContainer apps = rhpman.Install(allAdHocNodes);
 
   // Run the simulation with support for animations.
-  AnimationInterface anim(params.netanimTraceFilePath);
+  auto anim = std::unique_ptr<AnimationInterface>(
+      new AnimationInterface(params.netanimTraceFilePath));
   NS_LOG_UNCOND("Running simulation for " << params.runtime.GetSeconds() << " seconds...");
   Simulator::Stop(params.runtime);
   Simulator::Run();
+  NS_LOG_UNCOND(
+      "Profiles recomputed: " << rhpman.GetEngine()->GetProfilesRecomputed()
+                              << ", reused: " << rhpman.GetEngine()->GetProfilesReused());
+  NS_LOG_UNCOND("Replicas evicted: " << rhpman.GetEngine()->GetEvictions());
+  printElectionStats(apps);
+  if (Arena::GetRunArena() != nullptr) {
+    NS_LOG_UNCOND("Arena usage: " << Arena::GetRunArena()->GetStats());
+  }
+  if (params.fastTeardown) {
+    fastTeardown(std::move(anim), ss);
+  }
+  anim.reset();
   Simulator::Destroy();
+
+  // The apps and the engine hold memory from the run arena, so the last
+  // references to them must be gone before the arena is released.
+  apps = ApplicationContainer();
+  rhpman.ReleaseEngine();
+  Arena::ReleaseRunArena();
   NS_LOG_UNCOND("Done.");
 
   std::cout << ss.str() << std::endl;
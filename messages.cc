@@ -0,0 +1,619 @@
+/// \file messages.cc
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#include <algorithm>
+#include <cmath>
+
+#include "ns3/core-module.h"
+
+#include "messages.h"
+
+namespace rhpman {
+
+using namespace ns3;
+
+namespace {
+
+uint8_t typeByte(MessageType type, uint8_t flags) {
+  return static_cast<uint8_t>(type) | (flags << 4);
+}
+
+}  // namespace
+
+MessageType PeekMessageType(Ptr<const Packet> packet) {
+  uint8_t type = 0;
+  if (packet->CopyData(&type, 1) != 1) return MessageType::UNKNOWN;
+  return static_cast<MessageType>(type & 0x0f);
+}
+
+uint32_t GetVarintSize(uint32_t value) {
+  uint32_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+void WriteVarint(Buffer::Iterator& i, uint32_t value) {
+  while (value >= 0x80) {
+    i.WriteU8((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  i.WriteU8(value);
+}
+
+uint32_t ReadVarint(Buffer::Iterator& i) {
+  uint32_t value = 0;
+  for (uint32_t shift = 0; shift < 35; shift += 7) {
+    const uint8_t byte = i.ReadU8();
+    value |= uint32_t(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) break;
+  }
+  return value;
+}
+
+uint8_t EncodeProbability(float probability) {
+  return std::lround(std::min(std::max(probability, 0.0f), 1.0f) * 255.0f);
+}
+
+float DecodeProbability(uint8_t probability) { return probability / 255.0f; }
+
+NS_OBJECT_ENSURE_REGISTERED(ProfileHeader);
+
+// static
+TypeId ProfileHeader::GetTypeId() {
+  static TypeId id = TypeId("rhpman::ProfileHeader")
+                         .SetParent<Header>()
+                         .AddConstructor<ProfileHeader>();
+  return id;
+}
+
+ProfileHeader::ProfileHeader()
+    : m_node(0),
+      m_version(0),
+      m_storageVersion(0),
+      m_partition(0),
+      m_hops(0),
+      m_cdc(0),
+      m_colocation(),
+      m_pairs(),
+      m_delta(false),
+      m_baseVersion(0) {}
+
+void ProfileHeader::SetColocation(const float* colocation, uint32_t partitions) {
+  m_colocation.resize(partitions);
+  m_pairs.clear();
+  m_delta = false;
+  for (uint32_t p = 0; p < partitions; p++) {
+    m_colocation[p] = EncodeProbability(colocation[p]);
+    if (m_colocation[p] != 0) m_pairs.push_back(p);
+  }
+}
+
+void ProfileHeader::SetBaseline(const ProfileHeader& base) {
+  NS_ASSERT(!base.m_delta && base.m_node == m_node);
+  NS_ASSERT(base.m_colocation.size() == m_colocation.size());
+  m_delta = true;
+  m_baseVersion = base.m_version;
+  m_pairs.clear();
+  for (size_t p = 0; p < m_colocation.size(); p++) {
+    if (m_colocation[p] != base.m_colocation[p]) m_pairs.push_back(p);
+  }
+}
+
+void ProfileHeader::ApplyColocation(std::vector<float>& colocation) const {
+  if (!m_delta) {
+    colocation.resize(m_colocation.size());
+    for (size_t p = 0; p < m_colocation.size(); p++) {
+      colocation[p] = DecodeProbability(m_colocation[p]);
+    }
+    return;
+  }
+  NS_ASSERT(colocation.size() == m_colocation.size());
+  for (uint32_t p : m_pairs) {
+    colocation[p] = DecodeProbability(m_colocation[p]);
+  }
+}
+
+TypeId ProfileHeader::GetInstanceTypeId() const { return GetTypeId(); }
+
+// Pairs are sent in increasing order of partition, each partition as the gap
+// from the previous one.
+uint32_t ProfileHeader::getPairsSize() const {
+  uint32_t size = GetVarintSize(m_pairs.size());
+  uint32_t next = 0;
+  for (uint32_t p : m_pairs) {
+    size += GetVarintSize(p - next) + 1;
+    next = p + 1;
+  }
+  return size;
+}
+
+bool ProfileHeader::isSparse() const {
+  return m_delta || getPairsSize() < m_colocation.size();
+}
+
+uint32_t ProfileHeader::GetSerializedSize() const {
+  uint32_t size = 1 + GetVarintSize(m_node) + GetVarintSize(m_version) +
+                  GetVarintSize(m_storageVersion) + GetVarintSize(m_partition) + 1 +
+                  GetVarintSize(m_colocation.size());
+  if (m_delta) size += GetVarintSize(m_version - m_baseVersion);
+  if (m_hops > 0) size += 1;
+  return size + (isSparse() ? getPairsSize() : m_colocation.size());
+}
+
+void ProfileHeader::Serialize(Buffer::Iterator start) const {
+  const bool sparse = isSparse();
+  const uint8_t flags = (sparse ? kSparse : 0) | (m_delta ? kDelta : 0) | (m_hops ? kHops : 0);
+  start.WriteU8(typeByte(MessageType::PROFILE, flags));
+  WriteVarint(start, m_node);
+  WriteVarint(start, m_version);
+  if (m_delta) WriteVarint(start, m_version - m_baseVersion);
+  if (m_hops > 0) start.WriteU8(m_hops);
+  WriteVarint(start, m_storageVersion);
+  WriteVarint(start, m_partition);
+  start.WriteU8(m_cdc);
+  WriteVarint(start, m_colocation.size());
+  if (sparse) {
+    WriteVarint(start, m_pairs.size());
+    uint32_t next = 0;
+    for (uint32_t p : m_pairs) {
+      WriteVarint(start, p - next);
+      start.WriteU8(m_colocation[p]);
+      next = p + 1;
+    }
+  } else {
+    for (uint8_t colocation : m_colocation) {
+      start.WriteU8(colocation);
+    }
+  }
+}
+
+uint32_t ProfileHeader::Deserialize(Buffer::Iterator start) {
+  Buffer::Iterator i = start;
+  const uint8_t flags = i.ReadU8() >> 4;
+  m_delta = flags & kDelta;
+  m_node = ReadVarint(i);
+  m_version = ReadVarint(i);
+  m_baseVersion = m_delta ? m_version - ReadVarint(i) : 0;
+  m_hops = (flags & kHops) ? i.ReadU8() : 0;
+  m_storageVersion = ReadVarint(i);
+  m_partition = ReadVarint(i);
+  m_cdc = i.ReadU8();
+  m_colocation.assign(ReadVarint(i), 0);
+  m_pairs.clear();
+  if (flags & kSparse) {
+    const uint32_t pairs = ReadVarint(i);
+    uint32_t next = 0;
+    for (uint32_t n = 0; n < pairs; n++) {
+      const uint32_t p = next + ReadVarint(i);
+      const uint8_t colocation = i.ReadU8();
+      if (p < m_colocation.size()) {
+        m_colocation[p] = colocation;
+        m_pairs.push_back(p);
+      }
+      next = p + 1;
+    }
+  } else {
+    for (uint8_t& colocation : m_colocation) {
+      colocation = i.ReadU8();
+    }
+  }
+  return i.GetDistanceFrom(start);
+}
+
+void ProfileHeader::Print(std::ostream& os) const {
+  os << "node=" << m_node << " version=" << m_version;
+  if (m_delta) os << " base=" << m_baseVersion;
+  os << " hops=" << uint32_t(m_hops) << " storage=" << m_storageVersion
+     << " partition=" << m_partition << " cdc=" << GetDegreeConnectivity()
+     << " partitions=" << m_colocation.size();
+}
+
+NS_OBJECT_ENSURE_REGISTERED(SummaryHeader);
+
+// static
+TypeId SummaryHeader::GetTypeId() {
+  static TypeId id = TypeId("rhpman::SummaryHeader")
+                         .SetParent<Header>()
+                         .AddConstructor<SummaryHeader>();
+  return id;
+}
+
+SummaryHeader::SummaryHeader() : m_head(0), m_sequence(0), m_hops(0), m_profiles() {}
+
+TypeId SummaryHeader::GetInstanceTypeId() const { return GetTypeId(); }
+
+uint32_t SummaryHeader::GetSerializedSize() const {
+  uint32_t size = 1 + GetVarintSize(m_head) + GetVarintSize(m_sequence) + 1 +
+                  GetVarintSize(m_profiles.size());
+  for (const ProfileHeader& profile : m_profiles) {
+    size += profile.GetSerializedSize();
+  }
+  return size;
+}
+
+void SummaryHeader::Serialize(Buffer::Iterator start) const {
+  start.WriteU8(typeByte(MessageType::SUMMARY, 0));
+  WriteVarint(start, m_head);
+  WriteVarint(start, m_sequence);
+  start.WriteU8(m_hops);
+  WriteVarint(start, m_profiles.size());
+  for (const ProfileHeader& profile : m_profiles) {
+    profile.Serialize(start);
+    start.Next(profile.GetSerializedSize());
+  }
+}
+
+uint32_t SummaryHeader::Deserialize(Buffer::Iterator start) {
+  Buffer::Iterator i = start;
+  i.Next();
+  m_head = ReadVarint(i);
+  m_sequence = ReadVarint(i);
+  m_hops = i.ReadU8();
+  m_profiles.resize(ReadVarint(i));
+  for (ProfileHeader& profile : m_profiles) {
+    i.Next(profile.Deserialize(i));
+  }
+  return i.GetDistanceFrom(start);
+}
+
+void SummaryHeader::Print(std::ostream& os) const {
+  os << "head=" << m_head << " seq=" << m_sequence << " hops=" << uint32_t(m_hops)
+     << " profiles=" << m_profiles.size();
+}
+
+NS_OBJECT_ENSURE_REGISTERED(ElectionHeader);
+
+// static
+TypeId ElectionHeader::GetTypeId() {
+  static TypeId id = TypeId("rhpman::ElectionHeader")
+                         .SetParent<Header>()
+                         .AddConstructor<ElectionHeader>();
+  return id;
+}
+
+ElectionHeader::ElectionHeader()
+    : m_candidate(0), m_round(0), m_fitness(0), m_hops(0), m_flags(0) {}
+
+void ElectionHeader::SetReplicating(bool replicating) {
+  m_flags = replicating ? (m_flags | kReplicating) : (m_flags & ~kReplicating);
+}
+
+TypeId ElectionHeader::GetInstanceTypeId() const { return GetTypeId(); }
+
+uint32_t ElectionHeader::GetSerializedSize() const {
+  return 1 + GetVarintSize(m_candidate) + GetVarintSize(m_round) + 1 + 1;
+}
+
+void ElectionHeader::Serialize(Buffer::Iterator start) const {
+  start.WriteU8(typeByte(MessageType::ELECTION, m_flags));
+  WriteVarint(start, m_candidate);
+  WriteVarint(start, m_round);
+  start.WriteU8(m_fitness);
+  start.WriteU8(m_hops);
+}
+
+uint32_t ElectionHeader::Deserialize(Buffer::Iterator start) {
+  Buffer::Iterator i = start;
+  m_flags = i.ReadU8() >> 4;
+  m_candidate = ReadVarint(i);
+  m_round = ReadVarint(i);
+  m_fitness = i.ReadU8();
+  m_hops = i.ReadU8();
+  return i.GetDistanceFrom(start);
+}
+
+void ElectionHeader::Print(std::ostream& os) const {
+  os << "candidate=" << m_candidate << " round=" << m_round << " fitness=" << GetFitness()
+     << " hops=" << uint32_t(m_hops) << " replicating=" << IsReplicating();
+}
+
+NS_OBJECT_ENSURE_REGISTERED(DataHeader);
+
+// static
+TypeId DataHeader::GetTypeId() {
+  static TypeId id =
+      TypeId("rhpman::DataHeader").SetParent<Header>().AddConstructor<DataHeader>();
+  return id;
+}
+
+DataHeader::DataHeader()
+    : m_sender(0), m_recipient(0), m_dataId(0), m_sequence(0), m_size(0), m_flags(0) {}
+
+void DataHeader::SetForward(bool forward) {
+  m_flags = forward ? (m_flags | kForward) : (m_flags & ~kForward);
+}
+
+void DataHeader::SetCarry(bool carry) {
+  m_flags = carry ? (m_flags | kCarry) : (m_flags & ~kCarry);
+}
+
+void DataHeader::SetTrailer(bool trailer) {
+  m_flags = trailer ? (m_flags | kTrailer) : (m_flags & ~kTrailer);
+}
+
+TypeId DataHeader::GetInstanceTypeId() const { return GetTypeId(); }
+
+uint32_t DataHeader::GetSerializedSize() const {
+  return 1 + GetVarintSize(m_sender) + GetVarintSize(m_recipient) + GetVarintSize(m_dataId) +
+         GetVarintSize(m_sequence) + GetVarintSize(m_size);
+}
+
+void DataHeader::Serialize(Buffer::Iterator start) const {
+  start.WriteU8(typeByte(MessageType::DATA, m_flags));
+  WriteVarint(start, m_sender);
+  WriteVarint(start, m_recipient);
+  WriteVarint(start, m_dataId);
+  WriteVarint(start, m_sequence);
+  WriteVarint(start, m_size);
+}
+
+uint32_t DataHeader::Deserialize(Buffer::Iterator start) {
+  Buffer::Iterator i = start;
+  m_flags = i.ReadU8() >> 4;
+  m_sender = ReadVarint(i);
+  m_recipient = ReadVarint(i);
+  m_dataId = ReadVarint(i);
+  m_sequence = ReadVarint(i);
+  m_size = ReadVarint(i);
+  return i.GetDistanceFrom(start);
+}
+
+void DataHeader::Print(std::ostream& os) const {
+  os << "sender=" << m_sender << " recipient=" << m_recipient << " data=" << m_dataId
+     << " seq=" << m_sequence << " size=" << m_size << " forward=" << IsForward()
+     << " carry=" << IsCarry() << " trailer=" << HasTrailer();
+}
+
+NS_OBJECT_ENSURE_REGISTERED(ReconcileHeader);
+
+// static
+TypeId ReconcileHeader::GetTypeId() {
+  static TypeId id = TypeId("rhpman::ReconcileHeader")
+                         .SetParent<Header>()
+                         .AddConstructor<ReconcileHeader>();
+  return id;
+}
+
+ReconcileHeader::ReconcileHeader()
+    : m_sender(0), m_recipient(0), m_kind(REQUEST), m_table(), m_cells(0), m_data() {}
+
+TypeId ReconcileHeader::GetInstanceTypeId() const { return GetTypeId(); }
+
+uint32_t ReconcileHeader::GetSerializedSize() const {
+  uint32_t size = 1 + GetVarintSize(m_sender) + GetVarintSize(m_recipient);
+  switch (m_kind) {
+    case REQUEST:
+      return size + m_table.GetSerializedSize();
+    case RETRY:
+      return size + GetVarintSize(m_cells);
+    default:
+      return size + m_data.GetSerializedSize();
+  }
+}
+
+void ReconcileHeader::Serialize(Buffer::Iterator start) const {
+  start.WriteU8(typeByte(MessageType::RECONCILE, m_kind));
+  WriteVarint(start, m_sender);
+  WriteVarint(start, m_recipient);
+  switch (m_kind) {
+    case REQUEST:
+      m_table.Serialize(start);
+      break;
+    case RETRY:
+      WriteVarint(start, m_cells);
+      break;
+    default:
+      m_data.Serialize(start);
+      break;
+  }
+}
+
+uint32_t ReconcileHeader::Deserialize(Buffer::Iterator start) {
+  Buffer::Iterator i = start;
+  m_kind = static_cast<Kind>(i.ReadU8() >> 4);
+  m_sender = ReadVarint(i);
+  m_recipient = ReadVarint(i);
+  switch (m_kind) {
+    case REQUEST:
+      m_table.Deserialize(i);
+      break;
+    case RETRY:
+      m_cells = ReadVarint(i);
+      break;
+    default:
+      m_data.Deserialize(i);
+      break;
+  }
+  return i.GetDistanceFrom(start);
+}
+
+void ReconcileHeader::Print(std::ostream& os) const {
+  os << "sender=" << m_sender << " recipient=" << m_recipient << " kind=" << uint32_t(m_kind)
+     << " cells=" << (m_kind == REQUEST ? m_table.GetCells() : m_cells)
+     << " ids=" << m_data.GetSize();
+}
+
+NS_OBJECT_ENSURE_REGISTERED(AckHeader);
+
+// static
+TypeId AckHeader::GetTypeId() {
+  static TypeId id =
+      TypeId("rhpman::AckHeader").SetParent<Header>().AddConstructor<AckHeader>();
+  return id;
+}
+
+AckHeader::AckHeader() : m_sender(0), m_delivered() {}
+
+TypeId AckHeader::GetInstanceTypeId() const { return GetTypeId(); }
+
+uint32_t AckHeader::GetSerializedSize() const {
+  return 1 + GetVarintSize(m_sender) + m_delivered.GetSerializedSize();
+}
+
+void AckHeader::Serialize(Buffer::Iterator start) const {
+  start.WriteU8(typeByte(MessageType::ACK, 0));
+  WriteVarint(start, m_sender);
+  m_delivered.Serialize(start);
+}
+
+uint32_t AckHeader::Deserialize(Buffer::Iterator start) {
+  Buffer::Iterator i = start;
+  i.ReadU8();
+  m_sender = ReadVarint(i);
+  m_delivered.Deserialize(i);
+  return i.GetDistanceFrom(start);
+}
+
+void AckHeader::Print(std::ostream& os) const {
+  os << "sender=" << m_sender << " delivered=" << m_delivered.GetSize();
+}
+
+NS_OBJECT_ENSURE_REGISTERED(TransferHeader);
+
+// static
+TypeId TransferHeader::GetTypeId() {
+  static TypeId id = TypeId("rhpman::TransferHeader")
+                         .SetParent<Header>()
+                         .AddConstructor<TransferHeader>();
+  return id;
+}
+
+TransferHeader::TransferHeader()
+    : m_sender(0),
+      m_recipient(0),
+      m_kind(OFFER),
+      m_dataId(0),
+      m_fragments(0),
+      m_index(0),
+      m_missing() {}
+
+TypeId TransferHeader::GetInstanceTypeId() const { return GetTypeId(); }
+
+uint32_t TransferHeader::GetSerializedSize() const {
+  const uint32_t size =
+      1 + GetVarintSize(m_sender) + GetVarintSize(m_recipient) + GetVarintSize(m_dataId);
+  switch (m_kind) {
+    case OFFER:
+      return size + GetVarintSize(m_fragments);
+    case STATUS:
+      return size + GetVarintSize(m_index) + m_missing.GetSerializedSize();
+    default:
+      return size + GetVarintSize(m_fragments) + GetVarintSize(m_index);
+  }
+}
+
+void TransferHeader::Serialize(Buffer::Iterator start) const {
+  start.WriteU8(typeByte(MessageType::TRANSFER, m_kind));
+  WriteVarint(start, m_sender);
+  WriteVarint(start, m_recipient);
+  WriteVarint(start, m_dataId);
+  switch (m_kind) {
+    case OFFER:
+      WriteVarint(start, m_fragments);
+      break;
+    case STATUS:
+      WriteVarint(start, m_index);
+      m_missing.Serialize(start);
+      break;
+    default:
+      WriteVarint(start, m_fragments);
+      WriteVarint(start, m_index);
+      break;
+  }
+}
+
+uint32_t TransferHeader::Deserialize(Buffer::Iterator start) {
+  Buffer::Iterator i = start;
+  m_kind = static_cast<Kind>(i.ReadU8() >> 4);
+  m_sender = ReadVarint(i);
+  m_recipient = ReadVarint(i);
+  m_dataId = ReadVarint(i);
+  m_fragments = 0;
+  m_index = 0;
+  m_missing.Clear();
+  switch (m_kind) {
+    case OFFER:
+      m_fragments = ReadVarint(i);
+      break;
+    case STATUS:
+      m_index = ReadVarint(i);
+      m_missing.Deserialize(i);
+      break;
+    default:
+      m_fragments = ReadVarint(i);
+      m_index = ReadVarint(i);
+      break;
+  }
+  return i.GetDistanceFrom(start);
+}
+
+void TransferHeader::Print(std::ostream& os) const {
+  os << "sender=" << m_sender << " recipient=" << m_recipient << " kind=" << uint32_t(m_kind)
+     << " data=" << m_dataId << " fragments=" << m_fragments << " index=" << m_index
+     << " missing=" << m_missing.GetSize();
+}
+
+NS_OBJECT_ENSURE_REGISTERED(PiggybackTrailer);
+
+// static
+TypeId PiggybackTrailer::GetTypeId() {
+  static TypeId id = TypeId("rhpman::PiggybackTrailer")
+                         .SetParent<Trailer>()
+                         .AddConstructor<PiggybackTrailer>();
+  return id;
+}
+
+PiggybackTrailer::PiggybackTrailer() : m_profile(), m_round(0), m_replicating(false) {}
+
+TypeId PiggybackTrailer::GetInstanceTypeId() const { return GetTypeId(); }
+
+uint32_t PiggybackTrailer::GetSerializedSize() const {
+  // profile, election round, replicating flag, length
+  return m_profile.GetSerializedSize() + GetVarintSize(m_round) + 1 + 2;
+}
+
+void PiggybackTrailer::Serialize(Buffer::Iterator end) const {
+  const uint32_t size = GetSerializedSize();
+  Buffer::Iterator i = end;
+  i.Prev(size);
+  m_profile.Serialize(i);
+  i.Next(m_profile.GetSerializedSize());
+  WriteVarint(i, m_round);
+  i.WriteU8(m_replicating);
+  i.WriteHtonU16(size);
+}
+
+uint32_t PiggybackTrailer::Deserialize(Buffer::Iterator end) {
+  Buffer::Iterator i = end;
+  i.Prev(2);
+  const uint32_t size = i.ReadNtohU16();
+  i = end;
+  i.Prev(size);
+  i.Next(m_profile.Deserialize(i));
+  m_round = ReadVarint(i);
+  m_replicating = i.ReadU8();
+  return size;
+}
+
+void PiggybackTrailer::Print(std::ostream& os) const {
+  m_profile.Print(os);
+  os << " round=" << m_round << " replicating=" << m_replicating;
+}
+
+}  // namespace rhpman
@@ -0,0 +1,419 @@
+/// \file messages.h
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+/// \brief Declares the headers of the messages exchanged by RHPMAN apps.
+///
+///     Every message starts with a MessageType byte, so that a receiver can
+///     peek at the type before removing the header of the message.
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef __messages_h
+#define __messages_h
+
+#include <inttypes.h>
+#include <iostream>
+#include <vector>
+
+#include "ns3/buffer.h"
+#include "ns3/header.h"
+#include "ns3/packet.h"
+#include "ns3/trailer.h"
+
+#include "data-set.h"
+#include "iblt.h"
+
+namespace rhpman {
+
+using namespace ns3;
+
+/// \brief Identifies the kind of a message.
+///     The type is kept in the low 4 bits of the first byte of a message, and
+///     the high 4 bits hold flags which depend on the type.
+enum class MessageType : uint8_t {
+  UNKNOWN = 0,
+  PROFILE,
+  ELECTION,
+  DATA,
+  SUMMARY,
+  RECONCILE,
+  ACK,
+  TRANSFER
+};
+
+/// \brief Gets the type of the message at the start of a packet.
+MessageType PeekMessageType(Ptr<const Packet> packet);
+
+// Compact encodings shared by all message headers. Node ids, versions and
+// counts are unsigned LEB128 varints, and probabilities in [0, 1] are 8-bit
+// fixed point values in units of 1/255.
+
+uint32_t GetVarintSize(uint32_t value);
+void WriteVarint(Buffer::Iterator& i, uint32_t value);
+uint32_t ReadVarint(Buffer::Iterator& i);
+uint8_t EncodeProbability(float probability);
+float DecodeProbability(uint8_t probability);
+
+/// \brief A node's profile: its change in degree of connectivity and its
+///     colocation with each partition, along with the versions of the profile
+///     and of the node's storage.
+///
+///     Most nodes are only colocated with a few partitions, so colocation is
+///     sent as (partition, value) pairs of the non-zero values when that is
+///     smaller than sending every value. A profile can also be sent as a
+///     delta against an earlier version, in which case only the colocation
+///     values which changed since that version are sent.
+class ProfileHeader : public Header {
+ public:
+  static TypeId GetTypeId();
+
+  ProfileHeader();
+
+  uint32_t GetNode() const { return m_node; }
+  void SetNode(uint32_t node) { m_node = node; }
+  uint32_t GetVersion() const { return m_version; }
+  void SetVersion(uint32_t version) { m_version = version; }
+  uint32_t GetStorageVersion() const { return m_storageVersion; }
+  void SetStorageVersion(uint32_t version) { m_storageVersion = version; }
+  /// \brief The partition which the node was in when it sent the profile.
+  uint32_t GetPartition() const { return m_partition; }
+  void SetPartition(uint32_t partition) { m_partition = partition; }
+  /// \brief The number of times the profile is still to be forwarded.
+  uint8_t GetHops() const { return m_hops; }
+  void SetHops(uint8_t hops) { m_hops = hops; }
+  float GetDegreeConnectivity() const { return DecodeProbability(m_cdc); }
+  void SetDegreeConnectivity(float cdc) { m_cdc = EncodeProbability(cdc); }
+  uint32_t GetPartitions() const { return m_colocation.size(); }
+  void SetColocation(const float* colocation, uint32_t partitions);
+
+  /// \brief Makes this profile a delta against an earlier full profile of the
+  ///     same node and number of partitions.
+  void SetBaseline(const ProfileHeader& base);
+  bool IsDelta() const { return m_delta; }
+  uint32_t GetBaseVersion() const { return m_baseVersion; }
+
+  /// \brief Writes the colocation values carried by this profile into a
+  ///     vector of GetPartitions() values. A delta only writes the values
+  ///     which changed since its baseline, so the vector must hold the
+  ///     colocation of the baseline.
+  void ApplyColocation(std::vector<float>& colocation) const;
+
+  TypeId GetInstanceTypeId() const override;
+  uint32_t GetSerializedSize() const override;
+  void Serialize(Buffer::Iterator start) const override;
+  uint32_t Deserialize(Buffer::Iterator start) override;
+  void Print(std::ostream& os) const override;
+
+ private:
+  static constexpr uint8_t kSparse = 1;
+  static constexpr uint8_t kDelta = 2;
+  static constexpr uint8_t kHops = 4;
+
+  bool isSparse() const;
+  uint32_t getPairsSize() const;
+
+  uint32_t m_node;
+  uint32_t m_version;
+  uint32_t m_storageVersion;
+  uint32_t m_partition;
+  uint8_t m_hops;
+  uint8_t m_cdc;
+  std::vector<uint8_t> m_colocation;
+
+  // The partitions sent as (partition, value) pairs: those which changed
+  // since the baseline of a delta, or the non-zero ones of a full profile.
+  std::vector<uint32_t> m_pairs;
+
+  bool m_delta;
+  uint32_t m_baseVersion;
+};
+
+/// \brief The profiles of the members of a partition, merged by the cluster
+///     head of the partition into a single message which is forwarded over
+///     the neighborhood instead of each member's own profile.
+class SummaryHeader : public Header {
+ public:
+  static TypeId GetTypeId();
+
+  SummaryHeader();
+
+  uint32_t GetHead() const { return m_head; }
+  void SetHead(uint32_t head) { m_head = head; }
+  uint32_t GetSequence() const { return m_sequence; }
+  void SetSequence(uint32_t sequence) { m_sequence = sequence; }
+  /// \brief The number of times the summary is still to be forwarded.
+  uint8_t GetHops() const { return m_hops; }
+  void SetHops(uint8_t hops) { m_hops = hops; }
+  const std::vector<ProfileHeader>& GetProfiles() const { return m_profiles; }
+  void AddProfile(const ProfileHeader& profile) { m_profiles.push_back(profile); }
+
+  TypeId GetInstanceTypeId() const override;
+  uint32_t GetSerializedSize() const override;
+  void Serialize(Buffer::Iterator start) const override;
+  uint32_t Deserialize(Buffer::Iterator start) override;
+  void Print(std::ostream& os) const override;
+
+ private:
+  uint32_t m_head;
+  uint32_t m_sequence;
+  uint8_t m_hops;
+  std::vector<ProfileHeader> m_profiles;
+};
+
+/// \brief Announces a candidate in a replica holder election, flooded over
+///     the election neighborhood of the candidate.
+class ElectionHeader : public Header {
+ public:
+  static TypeId GetTypeId();
+
+  ElectionHeader();
+
+  uint32_t GetCandidate() const { return m_candidate; }
+  void SetCandidate(uint32_t candidate) { m_candidate = candidate; }
+  uint32_t GetRound() const { return m_round; }
+  void SetRound(uint32_t round) { m_round = round; }
+  float GetFitness() const { return DecodeProbability(m_fitness); }
+  void SetFitness(float fitness) { m_fitness = EncodeProbability(fitness); }
+  uint8_t GetHops() const { return m_hops; }
+  void SetHops(uint8_t hops) { m_hops = hops; }
+  bool IsReplicating() const { return m_flags & kReplicating; }
+  void SetReplicating(bool replicating);
+
+  TypeId GetInstanceTypeId() const override;
+  uint32_t GetSerializedSize() const override;
+  void Serialize(Buffer::Iterator start) const override;
+  uint32_t Deserialize(Buffer::Iterator start) override;
+  void Print(std::ostream& os) const override;
+
+ private:
+  static constexpr uint8_t kReplicating = 1;
+
+  uint32_t m_candidate;
+  uint32_t m_round;
+  uint8_t m_fitness;
+  uint8_t m_hops;
+  uint8_t m_flags;
+};
+
+/// \brief Precedes a data item which is sent to a neighbor, either to be
+///     forwarded towards its home partition or to be carried as a replica.
+///     Data is broadcast, so that every neighbor overhears it; only the
+///     recipient stores the item. A datagram may hold a batch of several
+///     data headers. The payloads of the items follow the last header, in the
+///     same order, and are zero-filled so that ns-3 never allocates them. The
+///     HasTrailer flag is set on the first header when the datagram ends with
+///     a PiggybackTrailer.
+class DataHeader : public Header {
+ public:
+  static TypeId GetTypeId();
+
+  DataHeader();
+
+  uint32_t GetSender() const { return m_sender; }
+  void SetSender(uint32_t sender) { m_sender = sender; }
+  uint32_t GetRecipient() const { return m_recipient; }
+  void SetRecipient(uint32_t recipient) { m_recipient = recipient; }
+  uint32_t GetDataId() const { return m_dataId; }
+  void SetDataId(uint32_t dataId) { m_dataId = dataId; }
+  uint32_t GetSequence() const { return m_sequence; }
+  void SetSequence(uint32_t sequence) { m_sequence = sequence; }
+  /// \brief The size of the payload of the item in bytes.
+  uint32_t GetSize() const { return m_size; }
+  void SetSize(uint32_t size) { m_size = size; }
+  bool IsForward() const { return m_flags & kForward; }
+  void SetForward(bool forward);
+  bool IsCarry() const { return m_flags & kCarry; }
+  void SetCarry(bool carry);
+  bool HasTrailer() const { return m_flags & kTrailer; }
+  void SetTrailer(bool trailer);
+
+  TypeId GetInstanceTypeId() const override;
+  uint32_t GetSerializedSize() const override;
+  void Serialize(Buffer::Iterator start) const override;
+  uint32_t Deserialize(Buffer::Iterator start) override;
+  void Print(std::ostream& os) const override;
+
+ private:
+  static constexpr uint8_t kForward = 1;
+  static constexpr uint8_t kCarry = 2;
+  static constexpr uint8_t kTrailer = 4;
+
+  uint32_t m_sender;
+  uint32_t m_recipient;
+  uint32_t m_dataId;
+  uint32_t m_sequence;
+  uint32_t m_size;
+  uint8_t m_flags;
+};
+
+/// \brief Reconciles the storage of two nodes which came into contact, so
+///     that each learns which data the other lacks. The node with the lower
+///     index sends a REQUEST holding an IBLT of its storage, sized for the
+///     expected difference. The recipient subtracts an IBLT of its own
+///     storage and, if the difference decodes, sends a REPLY with the ids the
+///     requester has and it lacks. Otherwise it asks for a larger table with
+///     a RETRY, and once a table would be larger than the storage itself, the
+///     requester sends its FULL storage instead.
+///     Like data, reconcile messages are broadcast and ignored by all but the
+///     recipient.
+class ReconcileHeader : public Header {
+ public:
+  enum Kind : uint8_t { REQUEST = 0, RETRY, FULL, REPLY };
+
+  static TypeId GetTypeId();
+
+  ReconcileHeader();
+
+  uint32_t GetSender() const { return m_sender; }
+  void SetSender(uint32_t sender) { m_sender = sender; }
+  uint32_t GetRecipient() const { return m_recipient; }
+  void SetRecipient(uint32_t recipient) { m_recipient = recipient; }
+  Kind GetKind() const { return m_kind; }
+  void SetKind(Kind kind) { m_kind = kind; }
+  /// \brief The table of a REQUEST.
+  const Iblt& GetTable() const { return m_table; }
+  void SetTable(const Iblt& table) { m_table = table; }
+  /// \brief The number of cells asked for by a RETRY.
+  uint32_t GetCells() const { return m_cells; }
+  void SetCells(uint32_t cells) { m_cells = cells; }
+  /// \brief The storage of a FULL message, or the ids of a REPLY.
+  const DataSet& GetData() const { return m_data; }
+  void SetData(const DataSet& data) { m_data = data; }
+
+  TypeId GetInstanceTypeId() const override;
+  uint32_t GetSerializedSize() const override;
+  void Serialize(Buffer::Iterator start) const override;
+  uint32_t Deserialize(Buffer::Iterator start) override;
+  void Print(std::ostream& os) const override;
+
+ private:
+  uint32_t m_sender;
+  uint32_t m_recipient;
+  Kind m_kind;
+  Iblt m_table;
+  uint32_t m_cells;
+  DataSet m_data;
+};
+
+/// \brief An anti-packet: the ids of the data items the sender knows were
+///     delivered to a replica holder in their home partition, batched into a
+///     DataSet. Nodes which hold any of these items drop their copies and
+///     stop forwarding them.
+class AckHeader : public Header {
+ public:
+  static TypeId GetTypeId();
+
+  AckHeader();
+
+  uint32_t GetSender() const { return m_sender; }
+  void SetSender(uint32_t sender) { m_sender = sender; }
+  const DataSet& GetDelivered() const { return m_delivered; }
+  void SetDelivered(const DataSet& delivered) { m_delivered = delivered; }
+
+  TypeId GetInstanceTypeId() const override;
+  uint32_t GetSerializedSize() const override;
+  void Serialize(Buffer::Iterator start) const override;
+  uint32_t Deserialize(Buffer::Iterator start) override;
+  void Print(std::ostream& os) const override;
+
+ private:
+  uint32_t m_sender;
+  DataSet m_delivered;
+};
+
+/// \brief Carries a data item which is too large for one datagram, split into
+///     numbered fragments. The sender opens a transfer with an OFFER, and the
+///     recipient answers with a STATUS: the end of the fragments it received
+///     so far, and the fragments before that end which it is missing. The
+///     sender then keeps up to a window of FRAGMENTs in flight, and repeats
+///     those the recipient reports as missing. Each FRAGMENT is followed by
+///     its payload.
+///     Like data, transfer messages are broadcast and ignored by all but the
+///     recipient.
+class TransferHeader : public Header {
+ public:
+  enum Kind : uint8_t { OFFER = 0, STATUS, FRAGMENT };
+
+  static TypeId GetTypeId();
+
+  TransferHeader();
+
+  uint32_t GetSender() const { return m_sender; }
+  void SetSender(uint32_t sender) { m_sender = sender; }
+  uint32_t GetRecipient() const { return m_recipient; }
+  void SetRecipient(uint32_t recipient) { m_recipient = recipient; }
+  Kind GetKind() const { return m_kind; }
+  void SetKind(Kind kind) { m_kind = kind; }
+  uint32_t GetDataId() const { return m_dataId; }
+  void SetDataId(uint32_t dataId) { m_dataId = dataId; }
+  /// \brief The number of fragments of the item, sent by OFFER and FRAGMENT.
+  uint32_t GetFragments() const { return m_fragments; }
+  void SetFragments(uint32_t fragments) { m_fragments = fragments; }
+  /// \brief The index of a FRAGMENT, or the end of a STATUS: one past the
+  ///     last fragment the recipient received.
+  uint32_t GetIndex() const { return m_index; }
+  void SetIndex(uint32_t index) { m_index = index; }
+  /// \brief The fragments before the end of a STATUS which are missing.
+  const DataSet& GetMissing() const { return m_missing; }
+  void SetMissing(const DataSet& missing) { m_missing = missing; }
+
+  TypeId GetInstanceTypeId() const override;
+  uint32_t GetSerializedSize() const override;
+  void Serialize(Buffer::Iterator start) const override;
+  uint32_t Deserialize(Buffer::Iterator start) override;
+  void Print(std::ostream& os) const override;
+
+ private:
+  uint32_t m_sender;
+  uint32_t m_recipient;
+  Kind m_kind;
+  uint32_t m_dataId;
+  uint32_t m_fragments;
+  uint32_t m_index;
+  DataSet m_missing;
+};
+
+/// \brief The latest profile of the sender and its election state, attached
+///     to outgoing data so that neighbors which overhear the data also learn
+///     the profile without a separate broadcast.
+///     The profile may be a delta, as when it is broadcast by itself. The
+///     trailer ends with its own length, so it can be removed without knowing
+///     its size in advance.
+class PiggybackTrailer : public Trailer {
+ public:
+  static TypeId GetTypeId();
+
+  PiggybackTrailer();
+
+  const ProfileHeader& GetProfile() const { return m_profile; }
+  void SetProfile(const ProfileHeader& profile) { m_profile = profile; }
+  uint32_t GetElectionRound() const { return m_round; }
+  void SetElectionRound(uint32_t round) { m_round = round; }
+  bool IsReplicating() const { return m_replicating; }
+  void SetReplicating(bool replicating) { m_replicating = replicating; }
+
+  TypeId GetInstanceTypeId() const override;
+  uint32_t GetSerializedSize() const override;
+  void Serialize(Buffer::Iterator end) const override;
+  uint32_t Deserialize(Buffer::Iterator end) override;
+  void Print(std::ostream& os) const override;
+
+ private:
+  ProfileHeader m_profile;
+  uint32_t m_round;
+  bool m_replicating;
+};
+
+}  // namespace rhpman
+
+#endif
@@ -0,0 +1,47 @@
+/// \file probability-cache.cc
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#include "probability-cache.h"
+
+namespace rhpman {
+
+const float* ProbabilityCache::Lookup(uint32_t neighbor, uint64_t epoch) {
+  auto found = m_entries.find(neighbor);
+  if (found == m_entries.end() || !found->second.valid || found->second.epoch != epoch) {
+    m_misses++;
+    return nullptr;
+  }
+  m_hits++;
+  return found->second.probability.data();
+}
+
+float* ProbabilityCache::Insert(uint32_t neighbor, uint64_t epoch, uint32_t partitions) {
+  Entry& entry = m_entries[neighbor];
+  entry.valid = true;
+  entry.epoch = epoch;
+  entry.probability.resize(partitions);
+  return entry.probability.data();
+}
+
+void ProbabilityCache::Invalidate(uint32_t neighbor) {
+  auto found = m_entries.find(neighbor);
+  if (found != m_entries.end() && found->second.valid) {
+    found->second.valid = false;
+    m_invalidations++;
+  }
+}
+
+}  // namespace rhpman
@@ -0,0 +1,79 @@
+/// \file probability-cache.h
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+/// \brief Declares a per-node cache of the delivery probabilities of its
+///     neighbors.
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef __probability_cache_h
+#define __probability_cache_h
+
+#include <inttypes.h>
+#include <unordered_map>
+#include <vector>
+
+namespace rhpman {
+
+/// \brief Caches the delivery probability of each neighbor for every
+///     partition, keyed by (neighbor, epoch).
+///     An entry is filled the first time a neighbor is looked up in an epoch,
+///     so that every later decision about that neighbor in the same epoch is
+///     a lookup. Entries of older epochs are refilled in place, so the
+///     entries of nodes which are no longer neighbors must be removed.
+class ProbabilityCache {
+ public:
+  ProbabilityCache() : m_entries(), m_hits(0), m_misses(0), m_invalidations(0) {}
+
+  /// \brief Looks up the probabilities of a neighbor for an epoch.
+  ///
+  /// \param neighbor The neighbor.
+  /// \param epoch The current epoch.
+  /// \return const float* The probability for each partition, or nullptr if
+  ///     the neighbor has no entry for the epoch; in which case the caller
+  ///     should fill one with Insert.
+  const float* Lookup(uint32_t neighbor, uint64_t epoch);
+
+  /// \brief Makes the entry of a neighbor for an epoch, to be filled with the
+  ///     probability for each of the given number of partitions.
+  float* Insert(uint32_t neighbor, uint64_t epoch, uint32_t partitions);
+
+  /// \brief Drops the entry of a neighbor, e.g. because it sent a new profile.
+  void Invalidate(uint32_t neighbor);
+
+  /// \brief Drops the entry of a node which is no longer a neighbor, and frees
+  ///     its memory.
+  void Remove(uint32_t neighbor) { m_entries.erase(neighbor); }
+
+  void Clear() { m_entries.clear(); }
+
+  uint64_t GetHits() const { return m_hits; }
+  uint64_t GetMisses() const { return m_misses; }
+  uint64_t GetInvalidations() const { return m_invalidations; }
+
+ private:
+  struct Entry {
+    bool valid;
+    uint64_t epoch;
+    std::vector<float> probability;
+  };
+
+  std::unordered_map<uint32_t, Entry> m_entries;
+  uint64_t m_hits;
+  uint64_t m_misses;
+  uint64_t m_invalidations;
+};
+
+}  // namespace rhpman
+
+#endif
@@ -0,0 +1,70 @@
+/// \file replica-cache.cc
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#include <limits>
+
+#include "ns3/assert.h"
+
+#include "replica-cache.h"
+
+namespace rhpman {
+
+void ReplicaCache::Insert(uint32_t dataId, uint32_t partition) {
+  if (!m_entries.emplace(dataId, Entry{partition, 0}).second) return;
+  if (partition >= m_byPartition.size()) m_byPartition.resize(partition + 1);
+  m_byPartition[partition].emplace(0, dataId);
+}
+
+void ReplicaCache::Remove(uint32_t dataId) {
+  auto found = m_entries.find(dataId);
+  if (found == m_entries.end()) return;
+  m_byPartition[found->second.partition].erase({found->second.hits, dataId});
+  m_entries.erase(found);
+}
+
+void ReplicaCache::Touch(uint32_t dataId) {
+  auto found = m_entries.find(dataId);
+  if (found == m_entries.end()) return;
+  Entry& entry = found->second;
+  auto& replicas = m_byPartition[entry.partition];
+  replicas.erase({entry.hits, dataId});
+  entry.hits++;
+  replicas.emplace(entry.hits, dataId);
+}
+
+uint32_t ReplicaCache::SelectVictim(const std::vector<float>& probability) const {
+  NS_ASSERT(!m_entries.empty());
+  double lowest = std::numeric_limits<double>::infinity();
+  std::pair<uint32_t, uint32_t> victim(0, 0);
+  for (uint32_t p = 0; p < m_byPartition.size(); p++) {
+    if (m_byPartition[p].empty()) continue;
+    const std::pair<uint32_t, uint32_t>& first = *m_byPartition[p].begin();
+    const double utility = double(p < probability.size() ? probability[p] : 0.0f) *
+                           (1.0 + first.first);
+    if (utility < lowest || (utility == lowest && first.second < victim.second)) {
+      lowest = utility;
+      victim = first;
+    }
+  }
+  return victim.second;
+}
+
+void ReplicaCache::Clear() {
+  m_entries.clear();
+  m_byPartition.clear();
+}
+
+}  // namespace rhpman
@@ -0,0 +1,79 @@
+/// \file replica-cache.h
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+/// \brief Declares the index a node uses to choose which replica to evict
+///     when its storage is full.
+///
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef __replica_cache_h
+#define __replica_cache_h
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rhpman {
+
+/// \brief Orders the replicas held by a node by their utility, which is the
+///     probability that the node delivers data of the replica's home
+///     partition times one plus the replica's hits. Hits count how often the
+///     replica was sent on or delivered again, as a measure of its
+///     popularity.
+///
+///     Replicas are kept in one ordered set per home partition, by hits. All
+///     replicas of a partition share the node's delivery probability, so the
+///     least useful replica is the first of one of the sets, and is found in
+///     O(P + log n) for P partitions. Profile changes therefore never
+///     reorder anything.
+class ReplicaCache {
+ public:
+  ReplicaCache() : m_entries(), m_byPartition() {}
+
+  size_t GetSize() const { return m_entries.size(); }
+  bool Contains(uint32_t dataId) const { return m_entries.count(dataId) > 0; }
+
+  void Insert(uint32_t dataId, uint32_t partition);
+  void Remove(uint32_t dataId);
+
+  /// \brief Counts a hit of a replica, if it is in the cache.
+  void Touch(uint32_t dataId);
+
+  /// \brief Finds the replica with the lowest utility; ties go to the lowest
+  ///     id. The cache must not be empty.
+  ///
+  /// \param probability The delivery probability of the node for each
+  ///     partition.
+  uint32_t SelectVictim(const std::vector<float>& probability) const;
+
+  void Clear();
+
+ private:
+  struct Entry {
+    uint32_t partition;
+    uint32_t hits;
+  };
+
+  std::unordered_map<uint32_t, Entry> m_entries;
+  // (hits, data id) of the replicas of each home partition.
+  std::vector<std::set<std::pair<uint32_t, uint32_t>>> m_byPartition;
+};
+
+}  // namespace rhpman
+
+#endif
@@ -0,0 +1,541 @@
+/// \file rhpman-engine.cc
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/double.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node.h"
+#include "ns3/uinteger.h"
+
+#include "logging.h"
+#include "nsutil.h"
+#include "rhpman-engine.h"
+#include "timer-wheel.h"
+
+namespace rhpman {
+
+using namespace ns3;
+
+NS_OBJECT_ENSURE_REGISTERED(RhpmanEngine);
+
+// static
+TypeId RhpmanEngine::GetTypeId() {
+  static TypeId id =
+      TypeId("rhpman::RhpmanEngine")
+          .SetParent<Object>()
+          .AddConstructor<RhpmanEngine>()
+          .AddAttribute(
+              "ForwardingThreshold",
+              "If probability of delivery to a node is higher than this value, data is forwarded "
+              "(sigma)",
+              DoubleValue(0.4),
+              MakeDoubleAccessor(&RhpmanEngine::m_forwardingThreshold),
+              MakeDoubleChecker<double>(0.0, 1.0))
+          .AddAttribute(
+              "CarryingThreshold",
+              "If probability of delivery to a node is hight than this value, data is cached (tau)",
+              DoubleValue(0.6),
+              MakeDoubleAccessor(&RhpmanEngine::m_carryingThreshold),
+              MakeDoubleChecker<double>(0.0, 1.0))
+          .AddAttribute(
+              "DegreeConnectivityWeight",
+              "Weight of degree connectivity for computing delivery probabilities (w_cdc)",
+              DoubleValue(0.5),
+              MakeDoubleAccessor(&RhpmanEngine::m_wcdc),
+              MakeDoubleChecker<double>(0.0))
+          .AddAttribute(
+              "ColocationWeight",
+              "Weight of colocation for computing delivery probabilities (w_col)",
+              DoubleValue(0.5),
+              MakeDoubleAccessor(&RhpmanEngine::m_wcol),
+              MakeDoubleChecker<double>(0.0))
+          .AddAttribute(
+              "NeighborhoodSize",
+              "Number of hops considered to be in the neighborhood of this node (h)",
+              UintegerValue(2),
+              MakeUintegerAccessor(&RhpmanEngine::m_neighborhoodHops),
+              MakeUintegerChecker<uint32_t>(1))
+          .AddAttribute(
+              "ElectionNeighborhoodSize",
+              "Number of hops considered to be in the election neighborhood of this node (h_r)",
+              UintegerValue(4),
+              MakeUintegerAccessor(&RhpmanEngine::m_electionNeighborhoodHops),
+              MakeUintegerChecker<uint32_t>(1))
+          .AddAttribute(
+              "ProfileUpdateDelay",
+              "Time to wait between profile update and exchange (T)",
+              TimeValue(6.0_sec),
+              MakeTimeAccessor(&RhpmanEngine::m_profileDelay),
+              MakeTimeChecker(0.1_sec))
+          .AddAttribute(
+              "ContactRadius",
+              "Distance within which two nodes are considered direct neighbors",
+              DoubleValue(100.0),
+              MakeDoubleAccessor(&RhpmanEngine::m_contactRadius),
+              MakeDoubleChecker<double>(0.0))
+          .AddAttribute(
+              "StorageCapacity",
+              "Number of replicas a node may hold besides its own data; 0 for no limit",
+              UintegerValue(0),
+              MakeUintegerAccessor(&RhpmanEngine::m_storageCapacity),
+              MakeUintegerChecker<uint32_t>())
+          .AddAttribute(
+              "WorkerThreads",
+              "Number of threads used for the per-node computations of each epoch",
+              UintegerValue(1),
+              MakeUintegerAccessor(&RhpmanEngine::m_workerThreads),
+              MakeUintegerChecker<uint32_t>(1));
+  return id;
+}
+
+RhpmanEngine::RhpmanEngine()
+    : m_forwardingThreshold(0.4),
+      m_carryingThreshold(0.6),
+      m_wcdc(0.5),
+      m_wcol(0.5),
+      m_neighborhoodHops(2),
+      m_electionNeighborhoodHops(4),
+      m_profileDelay(6.0_sec),
+      m_contactRadius(100.0),
+      m_storageCapacity(0),
+      m_workerThreads(1),
+      m_area(std::pair<double, double>(0.0, 0.0), std::pair<double, double>(1000.0, 1000.0)),
+      m_rows(1),
+      m_cols(1),
+      m_config(),
+      m_frozen(false),
+      m_started(0),
+      m_epoch(0),
+      m_profilesRecomputed(0),
+      m_profilesReused(0),
+      m_evictions(0),
+      m_epochTimer(),
+      m_pool() {
+  // Storage may live in the run arena, so it must be released along with the
+  // rest of the simulation rather than whenever the last reference goes away.
+  // The event holds a reference, so the engine lives until then.
+  Simulator::ScheduleDestroy(&RhpmanEngine::Dispose, Ptr<RhpmanEngine>(this));
+}
+
+RhpmanEngine::~RhpmanEngine() {}
+
+void RhpmanEngine::SetArea(const SimulationArea& area, uint32_t rows, uint32_t cols) {
+  NS_ASSERT(!m_frozen);
+  m_area = area;
+  m_rows = rows;
+  m_cols = cols;
+}
+
+uint32_t RhpmanEngine::AddNode(Ptr<Node> node, Role role, int32_t dataId, uint32_t dataSize) {
+  NS_ASSERT(!m_frozen);
+  const uint32_t index = m_nodes.size();
+  m_nodes.push_back(node);
+  m_mobility.push_back(node->GetObject<MobilityModel>());
+  m_x.push_back(0.0);
+  m_y.push_back(0.0);
+  m_partition.push_back(0);
+  m_role.push_back(role);
+  m_dataId.push_back(dataId);
+  m_cdc.push_back(0.0);
+  m_storage.push_back(Storage());
+  m_replicas.push_back(ReplicaCache());
+  m_profileVersion.push_back(0);
+  m_profilePartition.push_back(0);
+  m_profileStorageVersion.push_back(0);
+  m_storageVersion.push_back(0);
+  if (dataId >= 0) {
+    m_storage.back().Add(dataId);
+    if (uint32_t(dataId) >= m_dataSize.size()) m_dataSize.resize(dataId + 1, 0);
+    m_dataSize[dataId] = dataSize;
+  }
+  return index;
+}
+
+void RhpmanEngine::NodeStarted(uint32_t index) {
+  NS_ASSERT(index < m_nodes.size());
+  if (!m_frozen) {
+    freeze();
+  }
+  if (m_started++ == 0) {
+    m_epochTimer = TimerWheel::GetInstance()->Schedule(
+        m_config.profileDelay,
+        MakeCallback(&RhpmanEngine::runEpoch, this));
+  }
+}
+
+void RhpmanEngine::NodeStopped(uint32_t index) {
+  NS_ASSERT(index < m_nodes.size() && m_started > 0);
+  if (--m_started == 0) {
+    TimerWheel::GetInstance()->Cancel(m_epochTimer);
+  }
+}
+
+double RhpmanEngine::GetColocation(uint32_t index, uint32_t partition) const {
+  if (m_epoch == 0) return m_partition[index] == partition ? 1.0 : 0.0;
+  return double(m_residency[index * m_config.GetPartitions() + partition]) / m_epoch;
+}
+
+/// Nodes are assumed to keep their velocities, so the contact lasts until
+/// the distance between them, which changes along a line, reaches the radius.
+Time RhpmanEngine::GetContactTime(uint32_t index, uint32_t other) const {
+  const Vector a = m_mobility[index]->GetPosition();
+  const Vector b = m_mobility[other]->GetPosition();
+  const Vector va = m_mobility[index]->GetVelocity();
+  const Vector vb = m_mobility[other]->GetVelocity();
+  const double dx = b.x - a.x;
+  const double dy = b.y - a.y;
+  const double vx = vb.x - va.x;
+  const double vy = vb.y - va.y;
+
+  // Solve |d + v t| = r for the positive root.
+  const double radius = m_config.contactRadius;
+  const double slack = radius * radius - (dx * dx + dy * dy);
+  if (slack <= 0) return Seconds(0);
+  const double speed = vx * vx + vy * vy;
+  const double along = dx * vx + dy * vy;
+  const double time = speed > 0 ? (std::sqrt(along * along + speed * slack) - along) / speed
+                                : std::numeric_limits<double>::infinity();
+  if (time >= Time::Max().GetSeconds()) return Time::Max();
+  return Seconds(time);
+}
+
+double RhpmanEngine::GetDeliveryProbability(uint32_t index, uint32_t partition) const {
+  return m_config.wcdc * m_cdc[index] +
+         m_config.wcol * GetProfileColocation(index)[partition];
+}
+
+const float* RhpmanEngine::GetProfileColocation(uint32_t index) const {
+  return m_profileColocation.data() + index * m_config.GetPartitions();
+}
+
+uint32_t RhpmanEngine::GetHomePartition(uint32_t dataId) const {
+  NS_ASSERT(dataId < m_home.size());
+  return m_home[dataId];
+}
+
+uint32_t RhpmanEngine::GetDataSize(uint32_t dataId) const {
+  NS_ASSERT(dataId < m_dataSize.size());
+  return m_dataSize[dataId];
+}
+
+uint32_t RhpmanEngine::GetNeighborCount(uint32_t index) const {
+  if (m_neighborStart.empty()) return 0;
+  return m_neighborStart[index + 1] - m_neighborStart[index];
+}
+
+const uint32_t* RhpmanEngine::GetNeighbors(uint32_t index) const {
+  if (m_neighborStart.empty()) return nullptr;
+  return m_neighbors.data() + m_neighborStart[index];
+}
+
+bool RhpmanEngine::HasData(uint32_t index, uint32_t dataId) const {
+  return m_storage[index].Contains(dataId);
+}
+
+/// An item delivered again to a node which already holds it is in demand,
+/// and counts as a hit.
+bool RhpmanEngine::StoreData(uint32_t index,
+                             uint32_t dataId,
+                             std::vector<uint32_t>* evicted) {
+  if (!m_storage[index].Add(dataId)) {
+    m_replicas[index].Touch(dataId);
+    return true;
+  }
+  m_storageVersion[index]++;
+  if (int32_t(dataId) == m_dataId[index]) return true;
+
+  ReplicaCache& replicas = m_replicas[index];
+  replicas.Insert(dataId, GetHomePartition(dataId));
+  if (m_config.storageCapacity == 0 || replicas.GetSize() <= m_config.storageCapacity) {
+    return true;
+  }
+  const uint32_t partitions = m_config.GetPartitions();
+  m_evictionProbability.resize(partitions);
+  for (uint32_t p = 0; p < partitions; p++) {
+    m_evictionProbability[p] = GetDeliveryProbability(index, p);
+  }
+  const uint32_t victim = replicas.SelectVictim(m_evictionProbability);
+  replicas.Remove(victim);
+  m_storage[index].Remove(victim);
+  m_evictions++;
+  if (evicted != nullptr) evicted->push_back(victim);
+  return victim != dataId;
+}
+
+bool RhpmanEngine::RemoveData(uint32_t index, uint32_t dataId) {
+  if (!m_storage[index].Remove(dataId)) return false;
+  m_replicas[index].Remove(dataId);
+  m_storageVersion[index]++;
+  return true;
+}
+
+void RhpmanEngine::TouchData(uint32_t index, uint32_t dataId) {
+  m_replicas[index].Touch(dataId);
+}
+
+// override
+void RhpmanEngine::DoDispose() {
+  Ptr<TimerWheel> wheel = TimerWheel::PeekInstance();
+  if (wheel != 0) {
+    wheel->Cancel(m_epochTimer);
+  }
+  m_nodes.clear();
+  m_mobility.clear();
+  m_storage.clear();
+  m_replicas.clear();
+  m_pool.reset();
+  Object::DoDispose();
+}
+
+void RhpmanEngine::freeze() {
+  m_config.forwardingThreshold = m_forwardingThreshold;
+  m_config.carryingThreshold = m_carryingThreshold;
+  m_config.wcdc = m_wcdc;
+  m_config.wcol = m_wcol;
+  m_config.neighborhoodHops = m_neighborhoodHops;
+  m_config.electionNeighborhoodHops = m_electionNeighborhoodHops;
+  m_config.profileDelay = m_profileDelay;
+  m_config.contactRadius = m_contactRadius;
+  m_config.storageCapacity = m_storageCapacity;
+  m_config.area = m_area;
+  m_config.rows = m_rows;
+  m_config.cols = m_cols;
+  m_frozen = true;
+  // The decision kernel stores home partitions in a byte.
+  NS_ABORT_MSG_IF(m_config.GetPartitions() > 256, "RHPMAN supports at most 256 partitions");
+  // The neighbor grid is sized by the radius, which must be positive.
+  NS_ABORT_MSG_IF(!(m_config.contactRadius > 0), "ContactRadius must be positive");
+  m_pool.reset(new WorkerPool(m_workerThreads));
+
+  const uint32_t nodes = m_nodes.size();
+  m_residency.assign(nodes * m_config.GetPartitions(), 0);
+  m_neighborStart.assign(nodes + 1, 0);
+  m_prevNeighborStart.assign(nodes + 1, 0);
+
+  // Data items belong to the partition that their owner starts in.
+  updatePositions();
+  m_home.assign(nodes, 0);
+  for (uint32_t i = 0; i < nodes; i++) {
+    if (m_dataId[i] >= 0) {
+      if (uint32_t(m_dataId[i]) >= m_home.size()) {
+        m_home.resize(m_dataId[i] + 1, 0);
+      }
+      m_home[m_dataId[i]] = m_partition[i];
+    }
+  }
+
+  // Until the first epoch, nodes are only colocated with their own partition.
+  const uint32_t partitions = m_config.GetPartitions();
+  m_profileColocation.assign(nodes * partitions, 0.0f);
+  for (uint32_t i = 0; i < nodes; i++) {
+    m_profileColocation[i * partitions + m_partition[i]] = 1.0f;
+    m_profilePartition[i] = m_partition[i];
+    m_profileStorageVersion[i] = m_storageVersion[i];
+  }
+}
+
+void RhpmanEngine::runEpoch() {
+  m_epochTimer = TimerWheel::GetInstance()->Schedule(
+      m_config.profileDelay,
+      MakeCallback(&RhpmanEngine::runEpoch, this));
+
+  m_epoch++;
+  updatePositions();
+  updateNeighbors();
+  updateProfiles();
+  NS_LOG_DEBUG(
+      "RHPMAN epoch " << m_epoch << " recomputed " << m_profilesRecomputed << " and reused "
+                      << m_profilesReused << " profiles so far, mean cdc "
+                      << meanDegreeConnectivity());
+}
+
+void RhpmanEngine::updatePositions() {
+  const uint32_t nodes = m_nodes.size();
+  for (uint32_t i = 0; i < nodes; i++) {
+    const Vector pos = m_mobility[i]->GetPosition();
+    m_x[i] = pos.x;
+    m_y[i] = pos.y;
+    m_partition[i] = m_config.area.gridIndexOf(pos.x, pos.y, m_config.rows, m_config.cols);
+  }
+}
+
+void RhpmanEngine::updateNeighbors() {
+  const uint32_t nodes = m_nodes.size();
+  const double radius = m_config.contactRadius;
+  const SimulationArea& area = m_config.area;
+
+  std::swap(m_neighborStart, m_prevNeighborStart);
+  std::swap(m_neighbors, m_prevNeighbors);
+  m_neighbors.clear();
+
+  // Bucket the nodes into cells at least as wide as the contact radius with a
+  // counting sort, so that each node is only compared against the nodes in
+  // the 3x3 block of cells around its own. Cells may be wider than the radius
+  // without missing any neighbor, so a small radius does not get more cells
+  // than there are nodes.
+  const double limit = std::max<uint32_t>(1, nodes);
+  double columns = std::max(1.0, std::floor(area.deltaX() / radius));
+  double rows = std::max(1.0, std::floor(area.deltaY() / radius));
+  if (columns * rows > limit) {
+    const double scale = std::sqrt(limit / (columns * rows));
+    rows = std::max(1.0, std::floor(rows * scale));
+    columns = std::max(1.0, std::min(std::floor(columns * scale), std::floor(limit / rows)));
+  }
+  const int32_t cellsX = columns;
+  const int32_t cellsY = rows;
+  m_cellStart.assign(cellsX * cellsY + 1, 0);
+  m_cellNodes.resize(nodes);
+  m_nodeCell.resize(nodes);
+  for (uint32_t i = 0; i < nodes; i++) {
+    m_nodeCell[i] = area.gridIndexOf(m_x[i], m_y[i], cellsX, cellsY);
+    m_cellStart[m_nodeCell[i] + 1]++;
+  }
+  for (size_t c = 1; c < m_cellStart.size(); c++) {
+    m_cellStart[c] += m_cellStart[c - 1];
+  }
+  std::vector<uint32_t> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+  for (uint32_t i = 0; i < nodes; i++) {
+    m_cellNodes[fill[m_nodeCell[i]]++] = i;
+  }
+
+  // Each block of nodes collects its neighbors separately, and the blocks are
+  // then joined in order; the count of neighbors of node i is kept in
+  // m_neighborStart[i + 1] until the offsets are computed.
+  const double radiusSq = radius * radius;
+  m_blockNeighbors.resize(WorkerPool::GetBlocks(nodes));
+  m_pool->ForEachBlock(nodes, [&](uint32_t block, uint32_t begin, uint32_t end) {
+    std::vector<uint32_t>& found = m_blockNeighbors[block];
+    found.clear();
+    for (uint32_t i = begin; i < end; i++) {
+      const size_t first = found.size();
+      const int32_t cx = m_nodeCell[i] / cellsY;
+      const int32_t cy = m_nodeCell[i] % cellsY;
+      for (int32_t x = std::max(cx - 1, 0); x <= std::min(cx + 1, cellsX - 1); x++) {
+        for (int32_t y = std::max(cy - 1, 0); y <= std::min(cy + 1, cellsY - 1); y++) {
+          const int32_t cell = x * cellsY + y;
+          for (uint32_t k = m_cellStart[cell]; k < m_cellStart[cell + 1]; k++) {
+            const uint32_t j = m_cellNodes[k];
+            const double dx = m_x[i] - m_x[j];
+            const double dy = m_y[i] - m_y[j];
+            if (j != i && dx * dx + dy * dy <= radiusSq) {
+              found.push_back(j);
+            }
+          }
+        }
+      }
+      std::sort(found.begin() + first, found.end());
+      m_neighborStart[i + 1] = found.size() - first;
+    }
+  });
+
+  m_neighborStart[0] = 0;
+  for (uint32_t i = 0; i < nodes; i++) {
+    m_neighborStart[i + 1] += m_neighborStart[i];
+  }
+  for (const std::vector<uint32_t>& found : m_blockNeighbors) {
+    m_neighbors.insert(m_neighbors.end(), found.begin(), found.end());
+  }
+}
+
+void RhpmanEngine::updateProfiles() {
+  const uint32_t nodes = m_nodes.size();
+  const uint32_t partitions = m_config.GetPartitions();
+  const uint32_t recomputed = m_pool->Reduce(
+      nodes,
+      0u,
+      [&](uint32_t begin, uint32_t end) {
+        uint32_t count = 0;
+        for (uint32_t i = begin; i < end; i++) {
+          count += updateProfile(i, partitions);
+        }
+        return count;
+      },
+      std::plus<uint32_t>());
+  m_profilesRecomputed += recomputed;
+  m_profilesReused += nodes - recomputed;
+}
+
+/// Updates the residency of a node, and recomputes its profile if it changed.
+/// Returns true if the profile was recomputed.
+bool RhpmanEngine::updateProfile(uint32_t i, uint32_t partitions) {
+  m_residency[i * partitions + m_partition[i]]++;
+
+  // Both neighbor lists are sorted, so their union and intersection are found
+  // with a single merge.
+  const uint32_t* a = m_prevNeighbors.data() + m_prevNeighborStart[i];
+  const uint32_t* aEnd = m_prevNeighbors.data() + m_prevNeighborStart[i + 1];
+  const uint32_t* b = m_neighbors.data() + m_neighborStart[i];
+  const uint32_t* bEnd = m_neighbors.data() + m_neighborStart[i + 1];
+  uint32_t both = 0;
+  uint32_t either = 0;
+  while (a != aEnd && b != bEnd) {
+    either++;
+    if (*a < *b) {
+      a++;
+    } else if (*b < *a) {
+      b++;
+    } else {
+      both++;
+      a++;
+      b++;
+    }
+  }
+  either += (aEnd - a) + (bEnd - b);
+  const double cdc = either == 0 ? 0.0 : double(either - both) / either;
+
+  // A node which keeps its neighbors, partition and storage only drifts
+  // further towards its own partition, so the last profile is still a good
+  // estimate and is not recomputed. The cdc is compared as well so that a node
+  // which has just settled publishes its new cdc of 0 once.
+  const bool neighborsChanged = both != either;
+  if (!neighborsChanged && cdc == m_cdc[i] && m_partition[i] == m_profilePartition[i] &&
+      m_storageVersion[i] == m_profileStorageVersion[i]) {
+    return false;
+  }
+
+  m_cdc[i] = cdc;
+  float* colocation = &m_profileColocation[i * partitions];
+  const uint32_t* residency = &m_residency[i * partitions];
+  for (uint32_t p = 0; p < partitions; p++) {
+    colocation[p] = float(residency[p]) / m_epoch;
+  }
+  m_profilePartition[i] = m_partition[i];
+  m_profileStorageVersion[i] = m_storageVersion[i];
+  m_profileVersion[i]++;
+  return true;
+}
+
+double RhpmanEngine::meanDegreeConnectivity() const {
+  if (m_nodes.empty()) return 0.0;
+  const double sum = m_pool->Reduce(
+      m_nodes.size(),
+      0.0,
+      [this](uint32_t begin, uint32_t end) {
+        double partial = 0.0;
+        for (uint32_t i = begin; i < end; i++) partial += m_cdc[i];
+        return partial;
+      },
+      std::plus<double>());
+  return sum / m_nodes.size();
+}
+
+}  // namespace rhpman
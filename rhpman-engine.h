@@ -0,0 +1,304 @@
+/// \file rhpman-engine.h
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+/// \brief Declares the engine which owns the RHPMAN state of every node in a
+///     simulation.
+///
+///     Per-node state is kept in contiguous arrays indexed by node, so that the
+///     periodic profile update of every node is done in a single pass over
+///     memory once per epoch, rather than by one event per node.
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef __rhpman_engine_h
+#define __rhpman_engine_h
+
+#include <inttypes.h>
+#include <memory>
+#include <vector>
+
+#include "ns3/mobility-model.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+
+#include "data-set.h"
+#include "replica-cache.h"
+#include "simulation-area.h"
+#include "timer-wheel.h"
+#include "worker-pool.h"
+
+namespace rhpman {
+
+using namespace ns3;
+
+/// \brief RHPMAN parameters shared by every node of a simulation.
+///     The engine fixes its configuration when the first node starts, after
+///     which it is never modified.
+struct RhpmanConfig {
+  /// Delivery probability above which data is forwarded (sigma).
+  double forwardingThreshold;
+  /// Delivery probability above which data is carried (tau).
+  double carryingThreshold;
+  /// Weight of degree connectivity in delivery probabilities (w_cdc).
+  double wcdc;
+  /// Weight of colocation in delivery probabilities (w_col).
+  double wcol;
+  /// Number of hops in the neighborhood of a node (h).
+  uint32_t neighborhoodHops;
+  /// Number of hops in the election neighborhood of a node (h_r).
+  uint32_t electionNeighborhoodHops;
+  /// Time between profile updates (T).
+  Time profileDelay;
+  /// The radius within which two nodes are in contact.
+  double contactRadius;
+  /// The number of replicas a node may hold besides its own data; 0 for no
+  /// limit.
+  uint32_t storageCapacity;
+  /// The simulation area, split into a grid of partitions.
+  SimulationArea area;
+  /// The number of horizontal partitions.
+  uint32_t rows;
+  /// The number of vertical partitions.
+  uint32_t cols;
+
+  uint32_t GetPartitions() const { return rows * cols; }
+};
+
+/// \brief Owns the RHPMAN state of all nodes in a simulation.
+///     Each node is identified by the index returned when it was added.
+///
+///     Once per ProfileUpdateDelay, the engine runs an epoch in which it
+///     records the position and partition of every node, finds the direct
+///     neighbors of every node, and updates each node's profile: its change
+///     in degree of connectivity and its colocation with each partition.
+///     A profile is only recomputed, and given a new version, when the node's
+///     neighbors, partition or storage changed since it was last computed;
+///     otherwise the previous version is kept as is.
+///     The per-node work of an epoch is split over a WorkerPool of
+///     WorkerThreads threads, and gives the same results with any number of
+///     threads.
+class RhpmanEngine : public Object {
+ public:
+  enum Role { NON_REPLICATING = 0, REPLICATING };
+
+  /// Data items held by a node.
+  using Storage = DataSet;
+
+  static TypeId GetTypeId();
+
+  RhpmanEngine();
+  ~RhpmanEngine() override;
+
+  /// \brief Sets the area that nodes move in, and its partitioning.
+  void SetArea(const SimulationArea& area, uint32_t rows, uint32_t cols);
+
+  /// \brief Adds a node to the engine.
+  ///
+  /// \param node The node; it must have a MobilityModel.
+  /// \param role The initial role of the node.
+  /// \param dataId The data owned by the node, or a negative value if none.
+  /// \param dataSize The size of the payload of that data in bytes.
+  /// \return uint32_t The index of the node in the engine.
+  uint32_t AddNode(Ptr<Node> node, Role role, int32_t dataId, uint32_t dataSize = 0);
+
+  /// \brief Notifies the engine that the app of a node has started.
+  ///     The first call fixes the configuration and starts the epochs.
+  void NodeStarted(uint32_t index);
+
+  /// \brief Notifies the engine that the app of a node has stopped.
+  ///     Epochs stop when no started nodes remain.
+  void NodeStopped(uint32_t index);
+
+  const RhpmanConfig& GetConfig() const { return m_config; }
+  uint32_t GetNodes() const { return m_nodes.size(); }
+  uint64_t GetEpoch() const { return m_epoch; }
+
+  Role GetRole(uint32_t index) const { return static_cast<Role>(m_role[index]); }
+  void SetRole(uint32_t index, Role role) { m_role[index] = role; }
+  int32_t GetDataId(uint32_t index) const { return m_dataId[index]; }
+  uint32_t GetPartition(uint32_t index) const { return m_partition[index]; }
+
+  /// \brief Gets the change in degree of connectivity of a node over the last
+  ///     epoch, as a fraction of the neighbors it had in either epoch.
+  double GetDegreeConnectivity(uint32_t index) const { return m_cdc[index]; }
+
+  /// \brief Gets the fraction of epochs that a node spent in a partition.
+  double GetColocation(uint32_t index, uint32_t partition) const;
+
+  /// \brief Estimates how much longer two nodes stay within ContactRadius of
+  ///     each other, from their current positions and velocities.
+  ///
+  /// \return Time Zero if the nodes are not in contact, or Time::Max() if
+  ///     they move together.
+  Time GetContactTime(uint32_t index, uint32_t other) const;
+
+  /// \brief Computes the probability that a node delivers data which belongs
+  ///     to a partition, from the current version of its profile.
+  double GetDeliveryProbability(uint32_t index, uint32_t partition) const;
+
+  /// \brief Gets the version of a node's profile, which changes whenever the
+  ///     profile is recomputed.
+  uint32_t GetProfileVersion(uint32_t index) const { return m_profileVersion[index]; }
+
+  /// \brief Gets the colocation of a node with each partition, as of the
+  ///     current version of its profile.
+  const float* GetProfileColocation(uint32_t index) const;
+
+  /// \brief Gets the version of a node's storage, which changes whenever data
+  ///     is added to it.
+  uint32_t GetStorageVersion(uint32_t index) const { return m_storageVersion[index]; }
+
+  /// \brief Gets the number of profiles recomputed over all epochs.
+  uint64_t GetProfilesRecomputed() const { return m_profilesRecomputed; }
+
+  /// \brief Gets the number of profiles kept unchanged over all epochs.
+  uint64_t GetProfilesReused() const { return m_profilesReused; }
+
+  /// \brief Gets the home partition of a data item, which is the partition its
+  ///     owner was in when the simulation started.
+  uint32_t GetHomePartition(uint32_t dataId) const;
+
+  /// \brief Gets the size of the payload of a data item in bytes. Payloads
+  ///     are never stored, so items of any size take the same memory.
+  uint32_t GetDataSize(uint32_t dataId) const;
+
+  /// \brief Gets the number of direct neighbors of a node in the last epoch.
+  uint32_t GetNeighborCount(uint32_t index) const;
+
+  /// \brief Gets the direct neighbors of a node in the last epoch, sorted by
+  ///     index.
+  const uint32_t* GetNeighbors(uint32_t index) const;
+
+  const Storage& GetStorage(uint32_t index) const { return m_storage[index]; }
+  bool HasData(uint32_t index, uint32_t dataId) const;
+
+  /// \brief Adds a data item to the storage of a node. If this takes the node
+  ///     over its StorageCapacity, the replica with the lowest utility is
+  ///     evicted, which may be the new item itself.
+  ///
+  /// \param evicted If not null, receives the id of the evicted replica.
+  /// \return bool True if the node holds the item afterwards.
+  bool StoreData(uint32_t index, uint32_t dataId, std::vector<uint32_t>* evicted = nullptr);
+
+  /// \brief Drops a replica from the storage of a node.
+  ///
+  /// \return bool True if the node held the item.
+  bool RemoveData(uint32_t index, uint32_t dataId);
+
+  /// \brief Counts a use of a replica held by a node, which makes it less
+  ///     likely to be evicted.
+  void TouchData(uint32_t index, uint32_t dataId);
+
+  /// \brief Gets the number of replicas evicted from full storage.
+  uint64_t GetEvictions() const { return m_evictions; }
+
+ protected:
+  void DoDispose() override;
+
+ private:
+  void freeze();
+  void runEpoch();
+  void updatePositions();
+  void updateNeighbors();
+  void updateProfiles();
+  bool updateProfile(uint32_t index, uint32_t partitions);
+  double meanDegreeConnectivity() const;
+
+  // Attribute values; copied into m_config when the engine is frozen.
+
+  double m_forwardingThreshold;
+  double m_carryingThreshold;
+  double m_wcdc;
+  double m_wcol;
+  uint32_t m_neighborhoodHops;
+  uint32_t m_electionNeighborhoodHops;
+  Time m_profileDelay;
+  double m_contactRadius;
+  uint32_t m_storageCapacity;
+  uint32_t m_workerThreads;
+  SimulationArea m_area;
+  uint32_t m_rows;
+  uint32_t m_cols;
+
+  RhpmanConfig m_config;
+  bool m_frozen;
+  uint32_t m_started;
+  uint64_t m_epoch;
+  uint64_t m_profilesRecomputed;
+  uint64_t m_profilesReused;
+  uint64_t m_evictions;
+  TimerWheel::Handle m_epochTimer;
+  std::unique_ptr<WorkerPool> m_pool;
+
+  // Per-node state, indexed by node.
+
+  std::vector<Ptr<Node>> m_nodes;
+  std::vector<Ptr<MobilityModel>> m_mobility;
+  std::vector<double> m_x;
+  std::vector<double> m_y;
+  std::vector<uint32_t> m_partition;
+  std::vector<uint8_t> m_role;
+  std::vector<int32_t> m_dataId;
+  std::vector<double> m_cdc;
+  std::vector<Storage> m_storage;
+  // The replicas in each node's storage, by utility; its own data is never
+  // evicted, so it is not included.
+  std::vector<ReplicaCache> m_replicas;
+
+  /// Epochs spent by each node in each partition, indexed by
+  /// node * partitions + partition.
+  std::vector<uint32_t> m_residency;
+
+  // Current profile of each node, and the partition and storage version it
+  // was computed with. The colocation of node i with partition p is
+  // m_profileColocation[i * partitions + p].
+
+  std::vector<uint32_t> m_profileVersion;
+  std::vector<float> m_profileColocation;
+  std::vector<uint32_t> m_profilePartition;
+  std::vector<uint32_t> m_profileStorageVersion;
+  std::vector<uint32_t> m_storageVersion;
+
+  /// Home partition of each data item, indexed by data id.
+  std::vector<uint32_t> m_home;
+  /// Payload size of each data item, indexed by data id.
+  std::vector<uint32_t> m_dataSize;
+
+  // Direct neighbors of every node in compressed sparse row form: the
+  // neighbors of node i are m_neighbors[m_neighborStart[i]] up to
+  // m_neighbors[m_neighborStart[i + 1]]. The previous epoch is kept to compute
+  // the change in degree of connectivity.
+
+  std::vector<uint32_t> m_neighborStart;
+  std::vector<uint32_t> m_neighbors;
+  std::vector<uint32_t> m_prevNeighborStart;
+  std::vector<uint32_t> m_prevNeighbors;
+
+  // Scratch space for bucketing nodes into contact radius sized cells.
+
+  std::vector<uint32_t> m_cellStart;
+  std::vector<uint32_t> m_cellNodes;
+  std::vector<uint32_t> m_nodeCell;
+
+  /// Neighbors found for each block of nodes, before they are concatenated.
+  std::vector<std::vector<uint32_t>> m_blockNeighbors;
+
+  /// Scratch space for the delivery probabilities used to choose evictions.
+  std::vector<float> m_evictionProbability;
+};
+
+}  // namespace rhpman
+
+#endif
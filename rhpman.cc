@@ -15,23 +15,32 @@
 /// PERFORMANCE OF THIS SOFTWARE.
 
 #include <algorithm>
-#include <map>
+#include <cmath>
+#include <iterator>
+#include <limits>
 
 #include "ns3/application-container.h"
 #include "ns3/application.h"
 #include "ns3/applications-module.h"
 #include "ns3/attribute.h"
+#include "ns3/boolean.h"
 #include "ns3/core-module.h"
+#include "ns3/data-rate.h"
 #include "ns3/double.h"
 #include "ns3/enum.h"
 #include "ns3/node-container.h"
 #include "ns3/object-base.h"
 #include "ns3/object-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/ipv4-address.h"
 #include "ns3/pointer.h"
 #include "ns3/udp-socket-factory.h"
+#include "ns3/uinteger.h"
 
 #include "logging.h"
+#include "messages.h"
 #include "nsutil.h"
+#include "rhpman-engine.h"
 #include "rhpman.h"
 #include "util.h"
 
@@ -65,54 +74,176 @@ TypeId RhpmanApp::GetTypeId() {
               MakeIntegerAccessor(&RhpmanApp::m_dataId),
               MakeEmptyAttributeChecker())
           .AddAttribute(
-              "ForwardingThreshold",
-              "If probability of delivery to a node is higher than this value, data is forwarded "
-              "(sigma)",
-              DoubleValue(0.4),
-              MakeDoubleAccessor(&RhpmanApp::m_forwardingThreshold),
-              MakeDoubleChecker<double>(0.0, 1.0))
+              "Port",
+              "The UDP port that RHPMAN messages are sent and received on",
+              UintegerValue(5000),
+              MakeUintegerAccessor(&RhpmanApp::m_port),
+              MakeUintegerChecker<uint16_t>())
+          .AddAttribute(
+              "FullProfileInterval",
+              "Number of profiles sent as deltas between two full profiles; 0 disables deltas",
+              UintegerValue(8),
+              MakeUintegerAccessor(&RhpmanApp::m_fullProfileInterval),
+              MakeUintegerChecker<uint32_t>())
+          .AddAttribute(
+              "AggregateProfiles",
+              "Whether the cluster head of each partition forwards the profiles of its members",
+              BooleanValue(false),
+              MakeBooleanAccessor(&RhpmanApp::m_aggregateProfiles),
+              MakeBooleanChecker())
+          .AddAttribute(
+              "AdaptiveProfileDelay",
+              "Whether the time between profile exchanges adapts to neighborhood churn",
+              BooleanValue(false),
+              MakeBooleanAccessor(&RhpmanApp::m_adaptiveProfileDelay),
+              MakeBooleanChecker())
+          .AddAttribute(
+              "MaxProfileDelay",
+              "Longest time between profile exchanges of a node with a stable neighborhood",
+              TimeValue(60.0_sec),
+              MakeTimeAccessor(&RhpmanApp::m_maxProfileDelay),
+              MakeTimeChecker())
           .AddAttribute(
-              "CarryingThreshold",
-              "If probability of delivery to a node is hight than this value, data is cached (tau)",
-              DoubleValue(0.6),
-              MakeDoubleAccessor(&RhpmanApp::m_carryingThreshold),
+              "ChurnThreshold",
+              "Change in degree of connectivity above which profiles are exchanged every epoch",
+              DoubleValue(0.2),
+              MakeDoubleAccessor(&RhpmanApp::m_churnThreshold),
               MakeDoubleChecker<double>(0.0, 1.0))
           .AddAttribute(
-              "DegreeConnectivityWeight",
-              "Weight of degree connectivity for computing delivery probabilities (w_cdc)",
-              DoubleValue(0.5),
-              MakeDoubleAccessor(&RhpmanApp::m_wcdc),
-              MakeDoubleChecker<double>(0.0))
-          .AddAttribute(
-              "ColocationWeight",
-              "Weight of colocation for computing delivery probabilities (w_col)",
-              DoubleValue(0.5),
-              MakeDoubleAccessor(&RhpmanApp::m_wcol),
-              MakeDoubleChecker<double>(0.0))
-          .AddAttribute(
-              "NeighborhoodSize",
-              "Number of hops considered to be in the neighborhood of this node (h)",
-              UintegerValue(2),
-              MakeUintegerAccessor(&RhpmanApp::m_neighborhoodHops),
+              "StartJitter",
+              "Longest random delay of the first profile exchange after the app starts",
+              TimeValue(1.0_sec),
+              MakeTimeAccessor(&RhpmanApp::m_startJitter),
+              MakeTimeChecker())
+          .AddAttribute(
+              "BroadcastJitter",
+              "Longest random delay of each broadcast, so that neighbors do not send at once",
+              TimeValue(MilliSeconds(10)),
+              MakeTimeAccessor(&RhpmanApp::m_broadcastJitter),
+              MakeTimeChecker())
+          .AddAttribute(
+              "RebroadcastThreshold",
+              "Number of overheard copies of a message after which it is not forwarded; 0 disables",
+              UintegerValue(3),
+              MakeUintegerAccessor(&RhpmanApp::m_rebroadcastThreshold),
+              MakeUintegerChecker<uint32_t>())
+          .AddAttribute(
+              "SeenFilterCapacity",
+              "Number of forwarded messages remembered by each node to drop duplicates",
+              UintegerValue(1024),
+              MakeUintegerAccessor(&RhpmanApp::m_seenFilterCapacity),
+              MakeUintegerChecker<uint32_t>(1))
+          .AddAttribute(
+              "ReconcileOnContact",
+              "Whether nodes reconcile their storage to learn which data a new contact lacks",
+              BooleanValue(false),
+              MakeBooleanAccessor(&RhpmanApp::m_reconcileOnContact),
+              MakeBooleanChecker())
+          .AddAttribute(
+              "ReplicaTtl",
+              "Time after which a node drops a replica it received; 0 keeps replicas forever",
+              TimeValue(Seconds(0)),
+              MakeTimeAccessor(&RhpmanApp::m_replicaTtl),
+              MakeTimeChecker())
+          .AddAttribute(
+              "MaxTransfersPerTick",
+              "Number of data items a node may send on each data tick; 0 is unlimited",
+              UintegerValue(0),
+              MakeUintegerAccessor(&RhpmanApp::m_maxTransfersPerTick),
+              MakeUintegerChecker<uint32_t>())
+          .AddAttribute(
+              "AntiPackets",
+              "Whether nodes gossip which data was delivered, so that other holders drop it",
+              BooleanValue(false),
+              MakeBooleanAccessor(&RhpmanApp::m_antiPackets),
+              MakeBooleanChecker())
+          .AddAttribute(
+              "MaxBatchSize",
+              "Largest number of bytes of data items sent in one datagram; 0 sends each alone",
+              UintegerValue(0),
+              MakeUintegerAccessor(&RhpmanApp::m_maxBatchSize),
+              MakeUintegerChecker<uint32_t>())
+          .AddAttribute(
+              "BatchDelay",
+              "Time for which data items are collected before their datagram is sent",
+              TimeValue(MilliSeconds(2)),
+              MakeTimeAccessor(&RhpmanApp::m_batchDelay),
+              MakeTimeChecker())
+          .AddAttribute(
+              "DataSize",
+              "Size of the payload of the data owned by this node in bytes",
+              UintegerValue(0),
+              MakeUintegerAccessor(&RhpmanApp::m_dataSize),
+              MakeUintegerChecker<uint32_t>())
+          .AddAttribute(
+              "FragmentSize",
+              "Largest number of bytes of a data item sent in one datagram",
+              UintegerValue(1024),
+              MakeUintegerAccessor(&RhpmanApp::m_fragmentSize),
               MakeUintegerChecker<uint32_t>(1))
           .AddAttribute(
-              "ElectionNeighborhoodSize",
-              "Number of hops considered to be in the election neighborhood of this node (h_r)",
-              UintegerValue(4),
-              MakeUintegerAccessor(&RhpmanApp::m_electionNeighborhoodHops),
+              "TransferWindow",
+              "Largest number of fragments of a data item in flight at once",
+              UintegerValue(16),
+              MakeUintegerAccessor(&RhpmanApp::m_transferWindow),
               MakeUintegerChecker<uint32_t>(1))
           .AddAttribute(
-              "ProfileUpdateDelay",
-              "Time to wait between profile update and exchange (T)",
-              TimeValue(6.0_sec),
-              MakeTimeAccessor(&RhpmanApp::m_profileDelay),
-              MakeTimeChecker(0.1_sec));
+              "TransferTimeout",
+              "Time without an answer after which the sender of a data item asks for its status",
+              TimeValue(MilliSeconds(100)),
+              MakeTimeAccessor(&RhpmanApp::m_transferTimeout),
+              MakeTimeChecker())
+          .AddAttribute(
+              "TransferRetries",
+              "Number of timeouts in a row after which a transfer waits for a later contact",
+              UintegerValue(3),
+              MakeUintegerAccessor(&RhpmanApp::m_transferRetries),
+              MakeUintegerChecker<uint32_t>())
+          .AddAttribute(
+              "ContactAwareScheduling",
+              "Whether nodes only send each neighbor the data which fits in their contact",
+              BooleanValue(false),
+              MakeBooleanAccessor(&RhpmanApp::m_contactAwareScheduling),
+              MakeBooleanChecker())
+          .AddAttribute(
+              "LinkRate",
+              "Rate at which nodes expect to send data, to estimate how much fits in a contact",
+              DataRateValue(DataRate("1Mbps")),
+              MakeDataRateAccessor(&RhpmanApp::m_linkRate),
+              MakeDataRateChecker())
+          .AddAttribute(
+              "ElectionPeriod",
+              "Time between two replica holder elections",
+              TimeValue(120.0_sec),
+              MakeTimeAccessor(&RhpmanApp::m_electionPeriod),
+              MakeTimeChecker())
+          .AddAttribute(
+              "ElectionBackoff",
+              "Longest time a candidate waits before announcing itself in an election",
+              TimeValue(1.0_sec),
+              MakeTimeAccessor(&RhpmanApp::m_electionBackoff),
+              MakeTimeChecker())
+          .AddAttribute(
+              "ElectionTimeout",
+              "Time after the start of an election at which its winner is decided",
+              TimeValue(5.0_sec),
+              MakeTimeAccessor(&RhpmanApp::m_electionTimeout),
+              MakeTimeChecker());
   return id;
 }
 
+void RhpmanApp::SetEngine(Ptr<RhpmanEngine> engine) {
+  NS_ASSERT(m_engine == 0);
+  m_engine = engine;
+  m_index = engine->AddNode(GetNode(), m_role, m_dataId, m_dataSize);
+}
+
 Ptr<Socket> RhpmanApp::GetSocket() const { return m_socket; }
 
-RhpmanApp::Role RhpmanApp::GetRole() const { return m_role; }
+RhpmanApp::Role RhpmanApp::GetRole() const {
+  if (m_engine == 0) return m_role;
+  return m_engine->GetRole(m_index);
+}
 
 RhpmanApp::State RhpmanApp::GetState() const { return m_state; }
 
@@ -133,10 +264,35 @@ void RhpmanApp::StartApplication() {
 
   if (m_socket == 0) {
     m_socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
-    m_socket->Bind();
+    m_socket->Bind(InetSocketAddress(Ipv4Address::GetAny(), m_port));
+    m_socket->SetAllowBroadcast(true);
+    m_socket->SetRecvCallback(MakeCallback(&RhpmanApp::HandleRead, this));
   }
 
-  // TODO: Schedule events.
+  m_engine->NodeStarted(m_index);
+  m_seen = SeenFilter(kSeenFilterBitsPerMessage * m_seenFilterCapacity, m_seenFilterCapacity);
+  m_profileDelay = m_engine->GetConfig().profileDelay;
+  // Expiry is checked once per tick, so finer buckets would not help.
+  m_buffer = TransmitBuffer(m_profileDelay);
+  for (uint32_t dataId : m_engine->GetStorage(m_index)) {
+    m_buffer.Insert(dataId, Simulator::Now(), GetExpiry(dataId));
+  }
+  m_lastPartition = m_engine->GetPartition(m_index);
+  // Apps which start together would otherwise exchange profiles in lockstep.
+  const Time start = m_profileDelay + Seconds(m_random->GetValue(0, m_startJitter.GetSeconds()));
+  m_profileTimer = TimerWheel::GetInstance()->Schedule(
+      start,
+      MakeCallback(&RhpmanApp::ProfileTick, this));
+  m_dataTimer = TimerWheel::GetInstance()->Schedule(
+      start,
+      MakeCallback(&RhpmanApp::DataTick, this));
+  // Elections start on multiples of ElectionPeriod, so all nodes agree on
+  // their rounds.
+  const double period = m_electionPeriod.GetSeconds();
+  const double now = Simulator::Now().GetSeconds();
+  m_electionTimer = TimerWheel::GetInstance()->Schedule(
+      Seconds(period * (std::floor(now / period) + 1) - now),
+      MakeCallback(&RhpmanApp::ElectionTick, this));
 
   m_state = State::RUNNING;
 }
@@ -149,17 +305,1338 @@ void RhpmanApp::StopApplication() {
   }
   if (m_state == State::STOPPED) {
     NS_LOG_DEBUG("Ignoring RhpmanApp::StopApplication on already stopped instance");
+    return;
   }
 
-  // TODO: Cancel events.
+  CancelTimers();
+  m_engine->NodeStopped(m_index);
 
   m_state = State::STOPPED;
 }
 
+// override
+void RhpmanApp::DoDispose() {
+  CancelTimers();
+  m_peers.clear();
+  m_seen.Clear();
+  m_peerMissing.clear();
+  m_peerHeld.clear();
+  m_pendingRebroadcasts.clear();
+  m_probabilities.Clear();
+  m_buffer.Clear();
+  // Swapped out rather than cleared so that their memory is freed now, while
+  // the run arena it may come from is still alive.
+  DataSet().Swap(m_delivered);
+  DataSet().Swap(m_acked);
+  DataSet().Swap(m_destinationCopies);
+  m_ackNeighbors.clear();
+  m_partialItems.clear();
+  m_socket = 0;
+  m_engine = 0;
+  Application::DoDispose();
+}
+
+void RhpmanApp::CancelTimers() {
+  Ptr<TimerWheel> wheel = TimerWheel::PeekInstance();
+  if (wheel == 0) return;
+  wheel->Cancel(m_profileTimer);
+  wheel->Cancel(m_dataTimer);
+  wheel->Cancel(m_electionTimer);
+  wheel->Cancel(m_announceTimer);
+  wheel->Cancel(m_electionTimeoutTimer);
+  for (auto& entry : m_pendingRebroadcasts) {
+    Simulator::Cancel(entry.second.event);
+  }
+  m_pendingRebroadcasts.clear();
+  Simulator::Cancel(m_batchEvent);
+  m_batch.clear();
+  m_batchSize = 0;
+  for (auto& entry : m_outgoing) {
+    Simulator::Cancel(entry.second.timer);
+  }
+  m_outgoing.clear();
+}
+
+/// Runs every ProfileUpdateDelay while the app is running. Profiles
+/// themselves are updated by the engine for all nodes at once.
+void RhpmanApp::ProfileTick() {
+  ExpirePeers();
+  if (m_aggregateProfiles && IsClusterHead()) {
+    SendSummary();
+  } else if (UpdateProfile()) {
+    ExchangeProfiles();
+  } else {
+    m_profilesSuppressed++;
+  }
+  AdaptProfileDelay();
+  m_profileTimer = TimerWheel::GetInstance()->Schedule(
+      m_profileDelay,
+      MakeCallback(&RhpmanApp::ProfileTick, this));
+}
+
+/// Runs every epoch while the app is running, whatever its profile delay, so
+/// that a node which rarely sends its profile still forwards data as soon as
+/// its contacts change.
+void RhpmanApp::DataTick() {
+  UpdateContacts();
+  TransferData();
+  if (m_antiPackets) SendAcks();
+  m_dataTimer = TimerWheel::GetInstance()->Schedule(
+      m_engine->GetConfig().profileDelay,
+      MakeCallback(&RhpmanApp::DataTick, this));
+}
+
+/// Profiles change with every partition crossing and with neighbor churn, so
+/// a node which did either since its last tick goes back to ticking every
+/// epoch. Otherwise its neighborhood is stable, and the delay is doubled, up
+/// to MaxProfileDelay. The delay never drops below the engine's epoch, since
+/// profiles are not updated more often than that.
+void RhpmanApp::AdaptProfileDelay() {
+  if (!m_adaptiveProfileDelay) return;
+  const Time minimum = m_engine->GetConfig().profileDelay;
+  const uint32_t partition = m_engine->GetPartition(m_index);
+  const bool crossed = partition != m_lastPartition;
+  m_lastPartition = partition;
+  if (crossed || m_engine->GetDegreeConnectivity(m_index) > m_churnThreshold) {
+    m_profileDelay = minimum;
+  } else {
+    m_profileDelay = std::min(m_profileDelay * 2, std::max(minimum, m_maxProfileDelay));
+  }
+}
+
+void RhpmanApp::ElectionTick() {
+  const uint32_t round = std::lround(Simulator::Now().GetSeconds() / m_electionPeriod.GetSeconds());
+  // The election may already have been started by an announcement, or by
+  // the election state attached to data.
+  if (round > m_electionRound) StartElection(round);
+  m_electionTimer = TimerWheel::GetInstance()->Schedule(
+      m_electionPeriod,
+      MakeCallback(&RhpmanApp::ElectionTick, this));
+}
+
+/// Every node is a candidate, and waits for a backoff which is shorter the
+/// fitter it is before announcing itself. Fitter candidates are thus heard
+/// first, and a node which already knows a fitter candidate neither
+/// announces itself nor forwards weaker candidates. Each node sends at most
+/// one message per improvement of its best candidate, which keeps the
+/// overhead of an election bounded by the number of local maxima in fitness
+/// rather than by the number of nodes.
+void RhpmanApp::StartElection(uint32_t round) {
+  Ptr<TimerWheel> wheel = TimerWheel::GetInstance();
+  wheel->Cancel(m_announceTimer);
+  wheel->Cancel(m_electionTimeoutTimer);
+
+  m_electionRound = round;
+  m_electionBest = m_index;
+  m_electionBestFitness = GetFitness();
+  m_electionStart = Simulator::Now();
+  m_electionConverged = m_electionStart;
+  m_announceTimer = wheel->Schedule(
+      Seconds(m_electionBackoff.GetSeconds() * (1.0 - m_electionBestFitness)),
+      MakeCallback(&RhpmanApp::AnnounceCandidacy, this));
+  m_electionTimeoutTimer = wheel->Schedule(
+      m_electionTimeout,
+      MakeCallback(&RhpmanApp::ElectionTimeout, this));
+}
+
+void RhpmanApp::AnnounceCandidacy() {
+  if (m_electionBest != m_index) {
+    m_announcementsSuppressed++;
+    return;
+  }
+  ElectionHeader election;
+  election.SetCandidate(m_index);
+  election.SetRound(m_electionRound);
+  election.SetFitness(m_electionBestFitness);
+  election.SetHops(GetElectionHops());
+  election.SetReplicating(GetRole() == Role::REPLICATING);
+  Ptr<Packet> packet = Create<Packet>();
+  packet->AddHeader(election);
+  Broadcast(packet);
+  m_electionMessages++;
+}
+
+/// A node which has not heard of a fitter candidate within its election
+/// neighborhood by the timeout holds replicas until the next election.
+void RhpmanApp::ElectionTimeout() {
+  m_engine->SetRole(
+      m_index,
+      m_electionBest == m_index ? Role::REPLICATING : Role::NON_REPLICATING);
+  m_electionsHeld++;
+  m_electionConvergence += m_electionConverged - m_electionStart;
+}
+
+void RhpmanApp::HandleRead(Ptr<Socket> socket) {
+  Ptr<Packet> packet;
+  Address from;
+  while ((packet = socket->RecvFrom(from))) {
+    if (m_state != State::RUNNING) continue;
+    switch (PeekMessageType(packet)) {
+      case MessageType::PROFILE: {
+        ProfileHeader profile;
+        packet->RemoveHeader(profile);
+        ReceiveProfile(profile);
+        if (profile.GetNode() != m_index) ForwardProfile(profile);
+        break;
+      }
+      case MessageType::SUMMARY: {
+        SummaryHeader summary;
+        packet->RemoveHeader(summary);
+        ReceiveSummary(summary);
+        break;
+      }
+      case MessageType::ELECTION: {
+        ElectionHeader election;
+        packet->RemoveHeader(election);
+        ReceiveElection(election);
+        break;
+      }
+      case MessageType::DATA:
+        // A datagram may hold a batch of data items. Their payloads follow
+        // the headers, and start with a zero byte which ends the loop.
+        do {
+          ReceiveData(packet);
+        } while (packet->GetSize() > 0 && PeekMessageType(packet) == MessageType::DATA);
+        break;
+      case MessageType::RECONCILE: {
+        ReconcileHeader reconcile;
+        packet->RemoveHeader(reconcile);
+        if (reconcile.GetRecipient() == m_index) ReceiveReconcile(reconcile);
+        break;
+      }
+      case MessageType::TRANSFER:
+        ReceiveTransfer(packet);
+        break;
+      case MessageType::ACK: {
+        AckHeader ack;
+        packet->RemoveHeader(ack);
+        if (m_antiPackets && ack.GetSender() != m_index) ReceiveAcks(ack);
+        break;
+      }
+      default:
+        NS_LOG_DEBUG("Dropping RHPMAN message of unknown type");
+        break;
+    }
+  }
+}
+
+/// Returns true if the profile of this node has a version which has not been
+/// broadcast yet. The engine only changes the version when the profile was
+/// recomputed, so an unchanged profile is never sent twice.
+bool RhpmanApp::UpdateProfile() {
+  return !m_profileSent || m_engine->GetProfileVersion(m_index) != m_sentVersion;
+}
+
+/// Makes the next profile to send, either by itself or attached to data.
+/// If deltas are allowed, the profile is a delta against the last full
+/// profile when every current neighbor was also a neighbor when that full
+/// profile was sent, and so has implicitly received it. Otherwise, and after
+/// FullProfileInterval deltas, the full profile is sent and becomes the new
+/// baseline.
+ProfileHeader RhpmanApp::NextProfile(bool allowDelta) {
+  const uint32_t version = m_engine->GetProfileVersion(m_index);
+  ProfileHeader profile;
+  profile.SetNode(m_index);
+  profile.SetVersion(version);
+  profile.SetStorageVersion(m_engine->GetStorageVersion(m_index));
+  profile.SetPartition(m_engine->GetPartition(m_index));
+  profile.SetDegreeConnectivity(m_engine->GetDegreeConnectivity(m_index));
+  profile.SetColocation(
+      m_engine->GetProfileColocation(m_index),
+      m_engine->GetConfig().GetPartitions());
+
+  const bool delta = allowDelta && m_profileSent && m_deltasSinceFull < m_fullProfileInterval &&
+                     BaselineCoversNeighbors();
+  if (delta) {
+    profile.SetBaseline(m_baseline);
+    m_deltasSinceFull++;
+    m_deltaProfilesSent++;
+  } else {
+    m_baseline = profile;
+    const uint32_t* neighbors = m_engine->GetNeighbors(m_index);
+    m_baselineNeighbors.assign(neighbors, neighbors + m_engine->GetNeighborCount(m_index));
+    m_deltasSinceFull = 0;
+  }
+
+  m_sentVersion = version;
+  m_profileSent = true;
+  m_profileBytesSent += profile.GetSerializedSize();
+  return profile;
+}
+
+/// Profiles are forwarded over the neighborhood, unless profiles are
+/// aggregated, in which case the cluster head forwards them in its summary.
+/// Deltas only need to reach the first hop, since forwarders send on the full
+/// profile which they applied the delta to.
+void RhpmanApp::ExchangeProfiles() {
+  ProfileHeader profile = NextProfile(true);
+  profile.SetHops(m_aggregateProfiles ? 0 : GetForwardHops());
+  Ptr<Packet> packet = Create<Packet>();
+  packet->AddHeader(profile);
+  Broadcast(packet);
+  m_profilesSent++;
+}
+
+/// Copies of a profile which is already forwarded, or waiting to be, are
+/// only counted, including copies on their last hop. Nodes beyond the first
+/// hop do not hold the baseline of a delta, so the full profile the delta was
+/// applied to is forwarded instead, and a delta which could not be applied is
+/// dropped. A copy older than the profile held for its node shows that the
+/// neighbor which sent it is behind, so the held profile is sent in its place
+/// rather than waiting for the node's next profile.
+void RhpmanApp::ForwardProfile(ProfileHeader profile) {
+  const uint64_t key = SeenFilter::MakeKey(
+      uint8_t(MessageType::PROFILE),
+      profile.GetNode(),
+      profile.GetVersion());
+  if (m_seen.Contains(key)) {
+    OverheardRebroadcast(MessageType::PROFILE, profile.GetNode(), profile.GetVersion());
+    return;
+  }
+  if (profile.GetHops() == 0) return;
+  auto peer = m_peers.find(profile.GetNode());
+  if (peer == m_peers.end() || peer->second.version < profile.GetVersion()) return;
+  m_seen.Insert(key);
+
+  if (profile.IsDelta() || peer->second.version > profile.GetVersion()) {
+    const uint8_t hops = profile.GetHops();
+    profile = peer->second.ToHeader(profile.GetNode());
+    profile.SetHops(hops);
+    const RebroadcastKey held(MessageType::PROFILE, profile.GetNode(), profile.GetVersion());
+    if (m_pendingRebroadcasts.count(held) > 0) return;
+  }
+  profile.SetHops(profile.GetHops() - 1);
+  Ptr<Packet> packet = Create<Packet>();
+  packet->AddHeader(profile);
+  ScheduleRebroadcast(MessageType::PROFILE, profile.GetNode(), profile.GetVersion(), packet);
+}
+
+/// Broadcasts are delayed by a random jitter, so that neighbors which react
+/// to the same event do not collide. The wheel is too coarse for this, so the
+/// simulator schedules them directly.
+void RhpmanApp::Broadcast(Ptr<Packet> packet) {
+  if (m_broadcastJitter.IsZero()) {
+    SendBroadcast(packet);
+    return;
+  }
+  Simulator::Schedule(
+      Seconds(m_random->GetValue(0, m_broadcastJitter.GetSeconds())),
+      &RhpmanApp::SendBroadcast,
+      this,
+      packet);
+}
+
+void RhpmanApp::SendBroadcast(Ptr<Packet> packet) {
+  if (m_state != State::RUNNING) return;
+  m_socket->SendTo(packet, 0, InetSocketAddress(Ipv4Address::GetBroadcast(), m_port));
+}
+
+/// A forwarded message is held for a random time of up to BroadcastJitter,
+/// during which copies of it forwarded by neighbors are counted. If at least
+/// RebroadcastThreshold copies were overheard, the neighborhood has already
+/// been covered, and the message is dropped instead.
+void RhpmanApp::ScheduleRebroadcast(
+    MessageType type,
+    uint32_t origin,
+    uint32_t version,
+    Ptr<Packet> packet) {
+  PendingRebroadcast& pending = m_pendingRebroadcasts[RebroadcastKey(type, origin, version)];
+  pending.copies = 0;
+  pending.packet = packet;
+  pending.event = Simulator::Schedule(
+      Seconds(m_random->GetValue(0, m_broadcastJitter.GetSeconds())),
+      &RhpmanApp::Rebroadcast,
+      this,
+      type,
+      origin,
+      version);
+}
+
+void RhpmanApp::OverheardRebroadcast(MessageType type, uint32_t origin, uint32_t version) {
+  auto found = m_pendingRebroadcasts.find(RebroadcastKey(type, origin, version));
+  if (found != m_pendingRebroadcasts.end()) found->second.copies++;
+}
+
+void RhpmanApp::Rebroadcast(MessageType type, uint32_t origin, uint32_t version) {
+  auto found = m_pendingRebroadcasts.find(RebroadcastKey(type, origin, version));
+  if (found == m_pendingRebroadcasts.end()) return;
+  Ptr<Packet> packet = found->second.packet;
+  const uint32_t copies = found->second.copies;
+  m_pendingRebroadcasts.erase(found);
+
+  if (m_rebroadcastThreshold > 0 && copies >= m_rebroadcastThreshold) {
+    m_rebroadcastsSuppressed++;
+    return;
+  }
+  SendBroadcast(packet);
+  m_messagesForwarded++;
+  if (type == MessageType::ELECTION) m_electionMessages++;
+}
+
+uint8_t RhpmanApp::GetForwardHops() const {
+  return std::min<uint32_t>(m_engine->GetConfig().neighborhoodHops - 1, UINT8_MAX);
+}
+
+uint8_t RhpmanApp::GetElectionHops() const {
+  return std::min<uint32_t>(m_engine->GetConfig().electionNeighborhoodHops - 1, UINT8_MAX);
+}
+
+/// The cluster head of a partition is the member which has spent the most
+/// time there, or the lowest index of those if there are several. Members are
+/// known from the partition in the last profile heard from each peer which
+/// has not expired, and colocations are compared as they are sent, so that
+/// members which heard the same profiles agree on the head.
+bool RhpmanApp::IsClusterHead() const {
+  const uint32_t partition = m_engine->GetPartition(m_index);
+  const uint8_t own = EncodeProbability(m_engine->GetProfileColocation(m_index)[partition]);
+  for (const auto& entry : m_peers) {
+    const PeerProfile& peer = entry.second;
+    if (peer.partition != partition) continue;
+    const uint8_t other = EncodeProbability(peer.colocation[partition]);
+    if (other > own || (other == own && entry.first < m_index)) return false;
+  }
+  return true;
+}
+
+/// Merges the full profile of this node with the last profiles received from
+/// the other members of its partition, and forwards them over the
+/// neighborhood as a single message. Members then only send their own
+/// profile to their direct neighbors.
+void RhpmanApp::SendSummary() {
+  const uint32_t partition = m_engine->GetPartition(m_index);
+  SummaryHeader summary;
+  summary.SetHead(m_index);
+  summary.SetSequence(m_summarySequence++);
+  summary.SetHops(GetForwardHops());
+  summary.AddProfile(NextProfile(false));
+  for (const auto& entry : m_peers) {
+    if (entry.second.partition != partition) continue;
+    summary.AddProfile(entry.second.ToHeader(entry.first));
+  }
+
+  Ptr<Packet> packet = Create<Packet>();
+  packet->AddHeader(summary);
+  Broadcast(packet);
+  m_summariesSent++;
+}
+
+void RhpmanApp::ReceiveSummary(SummaryHeader summary) {
+  if (summary.GetHead() == m_index) return;
+  const uint64_t key = SeenFilter::MakeKey(
+      uint8_t(MessageType::SUMMARY),
+      summary.GetHead(),
+      summary.GetSequence());
+  if (m_seen.Contains(key)) {
+    OverheardRebroadcast(MessageType::SUMMARY, summary.GetHead(), summary.GetSequence());
+    return;
+  }
+  m_seen.Insert(key);
+
+  for (const ProfileHeader& profile : summary.GetProfiles()) {
+    ReceiveProfile(profile);
+  }
+  if (summary.GetHops() == 0) return;
+
+  summary.SetHops(summary.GetHops() - 1);
+  Ptr<Packet> packet = Create<Packet>();
+  packet->AddHeader(summary);
+  ScheduleRebroadcast(MessageType::SUMMARY, summary.GetHead(), summary.GetSequence(), packet);
+}
+
+bool RhpmanApp::BaselineCoversNeighbors() const {
+  const uint32_t* neighbors = m_engine->GetNeighbors(m_index);
+  return std::includes(
+      m_baselineNeighbors.begin(),
+      m_baselineNeighbors.end(),
+      neighbors,
+      neighbors + m_engine->GetNeighborCount(m_index));
+}
+
+/// A copy of this node's own profile which is older than its baseline shows
+/// that a neighbor cannot apply the next delta, so the next profile is a full
+/// one.
+void RhpmanApp::ReceiveProfile(const ProfileHeader& profile) {
+  if (profile.GetNode() == m_index) {
+    if (m_profileSent && profile.GetVersion() < m_baseline.GetVersion()) {
+      m_deltasSinceFull = m_fullProfileInterval;
+    }
+    return;
+  }
+  if (profile.GetPartitions() != m_engine->GetConfig().GetPartitions()) {
+    NS_LOG_DEBUG("Dropping profile with the wrong number of partitions");
+    return;
+  }
+  auto found = m_peers.find(profile.GetNode());
+  if (found != m_peers.end() && found->second.version >= profile.GetVersion()) {
+    if (found->second.version == profile.GetVersion()) found->second.heard = Simulator::Now();
+    return;
+  }
+  if (profile.IsDelta() &&
+      (found == m_peers.end() || found->second.baseVersion != profile.GetBaseVersion())) {
+    m_profileGaps++;
+    return;
+  }
+
+  PeerProfile& peer = m_peers[profile.GetNode()];
+  peer.version = profile.GetVersion();
+  peer.storageVersion = profile.GetStorageVersion();
+  peer.partition = profile.GetPartition();
+  peer.degreeConnectivity = profile.GetDegreeConnectivity();
+  if (profile.IsDelta()) {
+    peer.colocation = peer.baseline;
+  } else {
+    peer.baseVersion = profile.GetVersion();
+    profile.ApplyColocation(peer.baseline);
+  }
+  profile.ApplyColocation(peer.colocation);
+  peer.heard = Simulator::Now();
+  m_probabilities.Invalidate(profile.GetNode());
+}
+
+ProfileHeader RhpmanApp::PeerProfile::ToHeader(uint32_t node) const {
+  ProfileHeader profile;
+  profile.SetNode(node);
+  profile.SetVersion(version);
+  profile.SetStorageVersion(storageVersion);
+  profile.SetPartition(partition);
+  profile.SetDegreeConnectivity(degreeConnectivity);
+  profile.SetColocation(colocation.data(), colocation.size());
+  return profile;
+}
+
+/// Forgets peers which have not been heard from for kPeerLifetime maximum
+/// profile delays, the longest that a node waits between profile ticks, so
+/// that nodes which left the neighborhood neither compete for cluster head nor
+/// appear in summaries.
+void RhpmanApp::ExpirePeers() {
+  const Time epoch = m_engine->GetConfig().profileDelay;
+  const Time lifetime = std::max(epoch, m_maxProfileDelay) * kPeerLifetime;
+  const Time now = Simulator::Now();
+  for (auto peer = m_peers.begin(); peer != m_peers.end();) {
+    if (now - peer->second.heard <= lifetime) {
+      peer++;
+      continue;
+    }
+    m_probabilities.Invalidate(peer->first);
+    peer = m_peers.erase(peer);
+  }
+}
+
+/// Forgets what is known about ended contacts, and starts reconciling with
+/// new ones. Both nodes of a contact notice it, so only the one with the lower
+/// index starts. The first table is sized for the difference in storage
+/// versions of the two nodes, which is how many more items one has received.
+/// Reconcile messages are not acknowledged, so a contact which has not
+/// replied by the next tick lost one of them, and is asked again.
+void RhpmanApp::UpdateContacts() {
+  const uint32_t* neighbors = m_engine->GetNeighbors(m_index);
+  const std::vector<uint32_t> contacts(
+      neighbors,
+      neighbors + m_engine->GetNeighborCount(m_index));
+  std::vector<uint32_t> ended;
+  std::set_difference(
+      m_contacts.begin(),
+      m_contacts.end(),
+      contacts.begin(),
+      contacts.end(),
+      std::back_inserter(ended));
+  for (uint32_t neighbor : ended) {
+    m_peerMissing.erase(neighbor);
+    m_peerHeld.erase(neighbor);
+    m_probabilities.Remove(neighbor);
+  }
+
+  std::vector<uint32_t> started;
+  std::set_difference(
+      contacts.begin(),
+      contacts.end(),
+      m_contacts.begin(),
+      m_contacts.end(),
+      std::back_inserter(started));
+  if (!m_reconcileOnContact) {
+    for (uint32_t neighbor : started) m_peerHeld[neighbor];
+    m_contacts = contacts;
+    return;
+  }
+  for (uint32_t neighbor : contacts) {
+    if (neighbor < m_index || m_peerMissing.count(neighbor) > 0) continue;
+    if (!std::binary_search(started.begin(), started.end(), neighbor)) m_reconcileTimeouts++;
+    const uint32_t version = m_engine->GetStorageVersion(m_index);
+    auto peer = m_peers.find(neighbor);
+    const uint32_t other = peer == m_peers.end() ? version : peer->second.storageVersion;
+    const uint32_t difference = std::max(version, other) - std::min(version, other);
+    RequestReconcile(neighbor, Iblt::GetCellsFor(difference));
+  }
+  m_contacts = contacts;
+}
+
+void RhpmanApp::RequestReconcile(uint32_t neighbor, uint32_t cells) {
+  const RhpmanEngine::Storage& storage = m_engine->GetStorage(m_index);
+  ReconcileHeader reconcile;
+  reconcile.SetSender(m_index);
+  reconcile.SetRecipient(neighbor);
+  Iblt table(cells);
+  if (table.GetSerializedSize() >= storage.GetSerializedSize()) {
+    reconcile.SetKind(ReconcileHeader::FULL);
+    reconcile.SetData(storage);
+  } else {
+    for (uint32_t dataId : storage) table.Insert(dataId);
+    reconcile.SetKind(ReconcileHeader::REQUEST);
+    reconcile.SetTable(table);
+  }
+  SendReconcile(reconcile);
+}
+
+void RhpmanApp::SendReconcile(const ReconcileHeader& reconcile) {
+  Ptr<Packet> packet = Create<Packet>();
+  packet->AddHeader(reconcile);
+  Broadcast(packet);
+  m_reconcileBytesSent += reconcile.GetSerializedSize();
+}
+
+void RhpmanApp::ReceiveReconcile(const ReconcileHeader& reconcile) {
+  const uint32_t sender = reconcile.GetSender();
+  const RhpmanEngine::Storage& storage = m_engine->GetStorage(m_index);
+  switch (reconcile.GetKind()) {
+    case ReconcileHeader::RETRY:
+      RequestReconcile(sender, reconcile.GetCells());
+      return;
+    case ReconcileHeader::REPLY:
+      m_peerMissing[sender] = reconcile.GetData();
+      m_reconciliations++;
+      return;
+    default:
+      break;
+  }
+
+  // Both differences are needed: what the sender lacks is kept, and what
+  // this node lacks is sent back.
+  DataSet theirs;
+  DataSet mine;
+  if (reconcile.GetKind() == ReconcileHeader::FULL) {
+    theirs = reconcile.GetData();
+    theirs.Subtract(storage);
+    mine = storage;
+    mine.Subtract(reconcile.GetData());
+  } else {
+    Iblt table = reconcile.GetTable();
+    Iblt own(table.GetCells());
+    for (uint32_t dataId : storage) own.Insert(dataId);
+    table.Subtract(own);
+    std::vector<uint32_t> added;
+    std::vector<uint32_t> removed;
+    if (!table.Decode(added, removed)) {
+      m_reconcileRetries++;
+      ReconcileHeader retry;
+      retry.SetSender(m_index);
+      retry.SetRecipient(sender);
+      retry.SetKind(ReconcileHeader::RETRY);
+      retry.SetCells(2 * table.GetCells());
+      SendReconcile(retry);
+      return;
+    }
+    for (uint32_t dataId : added) theirs.Add(dataId);
+    for (uint32_t dataId : removed) mine.Add(dataId);
+  }
+  m_peerMissing[sender] = mine;
+  m_reconciliations++;
+
+  ReconcileHeader reply;
+  reply.SetSender(m_index);
+  reply.SetRecipient(sender);
+  reply.SetKind(ReconcileHeader::REPLY);
+  reply.SetData(theirs);
+  SendReconcile(reply);
+}
+
+/// A node never drops its own data.
+Time RhpmanApp::GetExpiry(uint32_t dataId) const {
+  if (m_replicaTtl.IsZero() || int32_t(dataId) == m_dataId) return Time::Max();
+  return Simulator::Now() + m_replicaTtl;
+}
+
+void RhpmanApp::ExpireReplicas() {
+  m_dropped.clear();
+  m_buffer.Expire(Simulator::Now(), m_dropped);
+  for (uint32_t dataId : m_dropped) {
+    m_destinationCopies.Remove(dataId);
+    if (m_engine->RemoveData(m_index, dataId)) m_replicasExpired++;
+  }
+}
+
+/// Without reconciliation, a neighbor lacks every item which it was not
+/// overheard to hold during the contact.
+bool RhpmanApp::PeerLacks(uint32_t neighbor, uint32_t dataId) const {
+  if (!m_reconcileOnContact) {
+    auto found = m_peerHeld.find(neighbor);
+    return found == m_peerHeld.end() || !found->second.Contains(dataId);
+  }
+  auto found = m_peerMissing.find(neighbor);
+  return found != m_peerMissing.end() && found->second.Contains(dataId);
+}
+
+/// Records that a contact holds an item, because it was overheard sending the
+/// item or being sent it.
+void RhpmanApp::PeerHolds(uint32_t neighbor, uint32_t dataId) {
+  auto missing = m_peerMissing.find(neighbor);
+  if (missing != m_peerMissing.end()) missing->second.Remove(dataId);
+  auto held = m_peerHeld.find(neighbor);
+  if (held != m_peerHeld.end()) held->second.Add(dataId);
+}
+
+/// Decisions are made from the last profiles received from the neighbors. A
+/// neighbor which has not sent a profile yet has no chance of delivering
+/// anything, as in GetDeliveryProbabilities.
+void RhpmanApp::ComputeDecisions() {
+  const uint32_t count = m_engine->GetNeighborCount(m_index);
+  const uint32_t* neighbors = m_engine->GetNeighbors(m_index);
+  const uint32_t partitions = m_engine->GetConfig().GetPartitions();
+  const RhpmanEngine::Storage& storage = m_engine->GetStorage(m_index);
+
+  m_kernelConnectivity.assign(count, 0.0f);
+  m_kernelColocation.assign(count * partitions, 0.0f);
+  for (uint32_t m = 0; m < count; m++) {
+    auto found = m_peers.find(neighbors[m]);
+    if (found == m_peers.end()) continue;
+    m_kernelConnectivity[m] = found->second.degreeConnectivity;
+    std::copy_n(
+        found->second.colocation.begin(),
+        partitions,
+        &m_kernelColocation[m * partitions]);
+  }
+  m_kernelHome.clear();
+  for (uint32_t dataId : storage) {
+    m_kernelHome.push_back(m_engine->GetHomePartition(dataId));
+  }
+
+  const RhpmanConfig& config = m_engine->GetConfig();
+  DecisionInputs in;
+  in.neighbors = count;
+  in.partitions = partitions;
+  in.items = storage.GetSize();
+  in.degreeConnectivity = m_kernelConnectivity.data();
+  in.colocation = m_kernelColocation.data();
+  in.home = m_kernelHome.data();
+  in.wcdc = float(config.wcdc);
+  in.wcol = float(config.wcol);
+  in.forwardingThreshold = config.forwardingThreshold;
+  in.carryingThreshold = config.carryingThreshold;
+  rhpman::ComputeDecisions(in, m_decisions);
+}
+
+/// Sends each data item in storage to each neighbor which should forward or
+/// carry it and does not have it yet. With reconciliation, a neighbor lacks
+/// an item if reconciling said so; until reconciling with a new contact
+/// completes, nothing is sent to it.
+/// Items are sent in the order of the transmit buffer: those which a neighbor
+/// is most likely to deliver go first, so that a short contact or a small
+/// MaxTransfersPerTick is spent on the most useful data.
+void RhpmanApp::TransferData() {
+  ExpireReplicas();
+  const uint32_t count = m_engine->GetNeighborCount(m_index);
+  if (count == 0) return;
+  ComputeDecisions();
+
+  const uint32_t* neighbors = m_engine->GetNeighbors(m_index);
+  const RhpmanEngine::Storage& storage = m_engine->GetStorage(m_index);
+  const uint32_t items = storage.GetSize();
+  m_transferWanted.assign(count * items, 0);
+  uint32_t k = 0;
+  for (uint32_t dataId : storage) {
+    // Data which was already delivered is not forwarded any further, and
+    // transfers in progress are left to finish.
+    const bool delivered = m_delivered.Contains(dataId);
+    for (uint32_t m = 0; m < count && !delivered; m++) {
+      m_transferWanted[m * items + k] =
+          (m_decisions.Forward(m, k) || m_decisions.Carry(m, k)) &&
+          PeerLacks(neighbors[m], dataId) &&
+          m_outgoing.count(TransferKey(neighbors[m], dataId)) == 0;
+    }
+    k++;
+  }
+  if (m_contactAwareScheduling) ScheduleContacts();
+
+  // An item is worth as much as the best neighbor which should receive it.
+  m_transferIndex.clear();
+  k = 0;
+  for (uint32_t dataId : storage) {
+    const uint32_t home = m_engine->GetHomePartition(dataId);
+    float priority = 0;
+    for (uint32_t m = 0; m < count; m++) {
+      if (m_transferWanted[m * items + k]) {
+        priority = std::max(priority, float(GetDeliveryProbability(neighbors[m], home)));
+      }
+    }
+    m_buffer.SetPriority(dataId, priority);
+    m_transferIndex[dataId] = k++;
+  }
+
+  // Sent items keep their place in the buffer, with no priority until they
+  // are prioritized again on the next tick.
+  uint32_t sent = 0;
+  while (!m_buffer.IsEmpty() && m_buffer.Top().priority > 0 &&
+         (m_maxTransfersPerTick == 0 || sent < m_maxTransfersPerTick)) {
+    const uint32_t dataId = m_buffer.Top().dataId;
+    m_buffer.SetPriority(dataId, 0);
+    sent++;
+    k = m_transferIndex[dataId];
+    for (uint32_t m = 0; m < count; m++) {
+      if (!m_transferWanted[m * items + k]) continue;
+      SendData(neighbors[m], dataId, m_decisions.Forward(m, k), m_decisions.Carry(m, k));
+      // A fragmented transfer has only started; ReceiveStatus records the
+      // item once the neighbor has all of it.
+      if (m_engine->GetDataSize(dataId) <= m_fragmentSize) PeerHolds(neighbors[m], dataId);
+    }
+  }
+}
+
+/// Items are chosen as for a knapsack with two limits: the bytes which the
+/// node can send before its next tick, which all of its neighbors share since
+/// they are sent over one channel, and the bytes which each neighbor can be
+/// sent before it moves out of range. (neighbor, item) pairs are taken
+/// greedily by delivery probability per byte, skipping those which no longer
+/// fit. Fragments of transfers in progress which are not acknowledged yet are
+/// taken off both limits first. Pairs which are not chosen are not started,
+/// rather than being cut off when the contact ends.
+void RhpmanApp::ScheduleContacts() {
+  const uint32_t count = m_engine->GetNeighborCount(m_index);
+  const uint32_t* neighbors = m_engine->GetNeighbors(m_index);
+  const RhpmanEngine::Storage& storage = m_engine->GetStorage(m_index);
+  const uint32_t items = storage.GetSize();
+  const double rate = m_linkRate.GetBitRate() / 8.0;
+  double airtime = m_engine->GetConfig().profileDelay.GetSeconds() * rate;
+  m_contactBudget.resize(count);
+  for (uint32_t m = 0; m < count; m++) {
+    const Time window = m_engine->GetContactTime(m_index, neighbors[m]);
+    m_contactBudget[m] = window == Time::Max() ? std::numeric_limits<double>::infinity()
+                                               : window.GetSeconds() * rate;
+  }
+  for (const auto& transfer : m_outgoing) {
+    const uint32_t cost = GetTransferCost(transfer.first.second, transfer.second.sender);
+    airtime -= cost;
+    const uint32_t* neighbor = std::lower_bound(neighbors, neighbors + count, transfer.first.first);
+    if (neighbor != neighbors + count && *neighbor == transfer.first.first) {
+      m_contactBudget[neighbor - neighbors] -= cost;
+    }
+  }
+
+  m_contactCandidates.clear();
+  for (uint32_t m = 0; m < count; m++) {
+    uint32_t k = 0;
+    for (uint32_t dataId : storage) {
+      if (m_transferWanted[m * items + k]) {
+        const uint32_t home = m_engine->GetHomePartition(dataId);
+        const uint32_t cost = GetItemCost(dataId);
+        const float value = GetDeliveryProbability(neighbors[m], home);
+        m_contactCandidates.push_back(ContactCandidate{value / cost, m, k, cost});
+      }
+      k++;
+    }
+  }
+  std::sort(
+      m_contactCandidates.begin(),
+      m_contactCandidates.end(),
+      [](const ContactCandidate& a, const ContactCandidate& b) { return a.density > b.density; });
+  for (const ContactCandidate& candidate : m_contactCandidates) {
+    double& budget = m_contactBudget[candidate.neighbor];
+    if (candidate.cost <= airtime && candidate.cost <= budget) {
+      airtime -= candidate.cost;
+      budget -= candidate.cost;
+    } else {
+      m_transferWanted[candidate.neighbor * items + candidate.item] = 0;
+      m_itemsDeferred++;
+    }
+  }
+}
+
+/// The bytes an item takes on the air: its payload, and the headers of every
+/// datagram it is sent in.
+uint32_t RhpmanApp::GetItemCost(uint32_t dataId) const {
+  const uint32_t size = m_engine->GetDataSize(dataId);
+  const uint32_t datagrams = size > m_fragmentSize ? GetFragmentCount(dataId) : 1;
+  return size + datagrams * kDatagramOverhead;
+}
+
+/// The bytes a transfer in progress still takes on the air: the fragments
+/// which are not acknowledged yet, and their headers.
+uint32_t RhpmanApp::GetTransferCost(uint32_t dataId, const FragmentSender& sender) const {
+  const uint32_t fragments = sender.GetUnacknowledged();
+  const uint32_t size = m_engine->GetDataSize(dataId);
+  return std::min<uint64_t>(uint64_t(fragments) * m_fragmentSize, size) +
+         fragments * kDatagramOverhead;
+}
+
+/// Data is broadcast so that all neighbors overhear it. Items are batched
+/// into one datagram of up to MaxBatchSize bytes, which is sent BatchDelay
+/// after its first item, or as soon as the next item would not fit. Each
+/// datagram then pays the per-frame overhead of the MAC only once.
+/// Items too large for one fragment are transferred in fragments instead.
+void RhpmanApp::SendData(uint32_t neighbor, uint32_t dataId, bool forward, bool carry) {
+  const uint32_t payload = m_engine->GetDataSize(dataId);
+  if (payload > m_fragmentSize) {
+    StartTransfer(neighbor, dataId);
+    return;
+  }
+  DataHeader header;
+  header.SetSender(m_index);
+  header.SetRecipient(neighbor);
+  header.SetDataId(dataId);
+  header.SetSequence(m_dataSequence++);
+  header.SetSize(payload);
+  header.SetForward(forward);
+  header.SetCarry(carry);
+
+  const uint32_t size = header.GetSerializedSize() + payload;
+  if (!m_batch.empty() && m_batchSize + size > m_maxBatchSize) FlushBatch();
+  m_batch.push_back(header);
+  m_batchSize += size;
+  m_engine->TouchData(m_index, dataId);
+  m_dataSent++;
+
+  if (m_maxBatchSize == 0) {
+    FlushBatch();
+  } else if (!m_batchEvent.IsRunning()) {
+    m_batchEvent = Simulator::Schedule(m_batchDelay, &RhpmanApp::FlushBatch, this);
+  }
+}
+
+/// While the profile has a version that was not sent yet, it is attached to
+/// the batch along with the election state, which makes a separate profile
+/// broadcast unnecessary. If it does not fit in the batch, the profile is
+/// broadcast by itself instead. Attached profiles are not forwarded, so this
+/// is only done when profiles are sent to direct neighbors alone; otherwise
+/// the profile is left for ProfileTick to flood over the neighborhood.
+void RhpmanApp::FlushBatch() {
+  Simulator::Cancel(m_batchEvent);
+  if (m_batch.empty()) return;
+
+  // The payloads of the batch form one zero-filled area after its headers,
+  // which ns-3 does not allocate.
+  uint32_t payload = 0;
+  for (const DataHeader& header : m_batch) {
+    payload += header.GetSize();
+  }
+  Ptr<Packet> packet = Create<Packet>(payload);
+  if ((m_aggregateProfiles || GetForwardHops() == 0) && UpdateProfile()) {
+    PiggybackTrailer trailer;
+    trailer.SetProfile(NextProfile(true));
+    trailer.SetElectionRound(m_electionRound);
+    trailer.SetReplicating(GetRole() == Role::REPLICATING);
+    if (m_maxBatchSize == 0 || m_batchSize + trailer.GetSerializedSize() <= m_maxBatchSize) {
+      packet->AddTrailer(trailer);
+      m_batch.front().SetTrailer(true);
+      m_profilesPiggybacked++;
+    } else {
+      Ptr<Packet> profile = Create<Packet>();
+      profile->AddHeader(trailer.GetProfile());
+      Broadcast(profile);
+      m_profilesSent++;
+    }
+  }
+  // Headers are added to the front of the packet, so the batch is added in
+  // reverse to keep its order.
+  for (auto header = m_batch.rbegin(); header != m_batch.rend(); header++) {
+    packet->AddHeader(*header);
+  }
+  Broadcast(packet);
+  m_batch.clear();
+  m_batchSize = 0;
+  m_batchesSent++;
+}
+
+void RhpmanApp::ReceiveData(Ptr<Packet> packet) {
+  DataHeader header;
+  packet->RemoveHeader(header);
+  if (header.HasTrailer()) {
+    PiggybackTrailer trailer;
+    packet->RemoveTrailer(trailer);
+    ReceivePiggyback(trailer);
+  }
+  const uint32_t dataId = header.GetDataId();
+  PeerHolds(header.GetSender(), dataId);
+  if (header.GetRecipient() != m_index) {
+    // The overheard recipient no longer lacks the data.
+    PeerHolds(header.GetRecipient(), dataId);
+    return;
+  }
+  StoreItem(header.GetSender(), dataId);
+}
+
+void RhpmanApp::StoreItem(uint32_t sender, uint32_t dataId) {
+  const bool destination = IsDestination(dataId);
+  if (m_delivered.Contains(dataId) && !destination) {
+    m_dataReceived++;
+    return;
+  }
+
+  // New data is assumed to be lacking at every contact but its sender.
+  const bool held = m_engine->HasData(m_index, dataId);
+  m_dropped.clear();
+  const bool stored = m_engine->StoreData(m_index, dataId, &m_dropped);
+  for (uint32_t evicted : m_dropped) {
+    m_buffer.Remove(evicted);
+    m_destinationCopies.Remove(evicted);
+  }
+  if (stored && !held) {
+    m_buffer.Insert(dataId, Simulator::Now(), GetExpiry(dataId));
+    for (auto& entry : m_peerMissing) {
+      if (entry.first != sender) entry.second.Add(dataId);
+    }
+  }
+  if (m_antiPackets && destination && stored) {
+    m_delivered.Add(dataId);
+    m_destinationCopies.Add(dataId);
+  }
+  m_dataReceived++;
+}
+
+/// Data reaches its destination once a replica holder in its home partition
+/// stores it; copies held anywhere else are then redundant.
+bool RhpmanApp::IsDestination(uint32_t dataId) const {
+  return GetRole() == Role::REPLICATING &&
+         m_engine->GetPartition(m_index) == m_engine->GetHomePartition(dataId);
+}
+
+bool RhpmanApp::IsRedundant(uint32_t dataId) const {
+  return m_delivered.Contains(dataId) && !IsDestination(dataId);
+}
+
+uint32_t RhpmanApp::GetFragmentCount(uint32_t dataId) const {
+  return (m_engine->GetDataSize(dataId) + m_fragmentSize - 1) / m_fragmentSize;
+}
+
+/// Large items are sent in fragments, over a selective repeat window. The
+/// transfer starts with an offer, which the neighbor answers with what it
+/// already received of the item, so a transfer cut short by the end of a
+/// contact resumes where it stopped.
+void RhpmanApp::StartTransfer(uint32_t neighbor, uint32_t dataId) {
+  const TransferKey key(neighbor, dataId);
+  if (m_outgoing.count(key) > 0) return;
+  OutgoingTransfer& transfer = m_outgoing[key];
+  transfer.sender = FragmentSender(GetFragmentCount(dataId), m_transferWindow);
+  transfer.retries = 0;
+  m_engine->TouchData(m_index, dataId);
+  SendOffer(neighbor, dataId);
+}
+
+/// Transfer messages are sent without jitter, which would reorder the
+/// fragments of a window and make them look lost.
+void RhpmanApp::SendOffer(uint32_t neighbor, uint32_t dataId) {
+  OutgoingTransfer& transfer = m_outgoing[TransferKey(neighbor, dataId)];
+  TransferHeader offer;
+  offer.SetKind(TransferHeader::OFFER);
+  offer.SetSender(m_index);
+  offer.SetRecipient(neighbor);
+  offer.SetDataId(dataId);
+  offer.SetFragments(transfer.sender.GetFragments());
+  Ptr<Packet> packet = Create<Packet>();
+  packet->AddHeader(offer);
+  SendBroadcast(packet);
+
+  Simulator::Cancel(transfer.timer);
+  transfer.timer =
+      Simulator::Schedule(m_transferTimeout, &RhpmanApp::TransferTimeout, this, neighbor, dataId);
+}
+
+/// The payload of a fragment is never read, so it is left zero-filled, which
+/// ns-3 does not allocate.
+void RhpmanApp::SendFragments(
+    uint32_t neighbor,
+    uint32_t dataId,
+    const std::vector<uint32_t>& indices) {
+  const uint32_t fragments = GetFragmentCount(dataId);
+  const uint32_t size = m_engine->GetDataSize(dataId);
+  for (uint32_t index : indices) {
+    TransferHeader fragment;
+    fragment.SetKind(TransferHeader::FRAGMENT);
+    fragment.SetSender(m_index);
+    fragment.SetRecipient(neighbor);
+    fragment.SetDataId(dataId);
+    fragment.SetFragments(fragments);
+    fragment.SetIndex(index);
+    Ptr<Packet> packet =
+        Create<Packet>(std::min(m_fragmentSize, size - index * m_fragmentSize));
+    packet->AddHeader(fragment);
+    SendBroadcast(packet);
+    m_fragmentsSent++;
+  }
+}
+
+/// A neighbor which stopped answering is asked for its status again, and
+/// every fragment in flight is sent again once it answers. The neighbor keeps
+/// what it received when the transfer is given up, so a later offer resumes
+/// it.
+void RhpmanApp::TransferTimeout(uint32_t neighbor, uint32_t dataId) {
+  auto found = m_outgoing.find(TransferKey(neighbor, dataId));
+  if (found == m_outgoing.end()) return;
+  OutgoingTransfer& transfer = found->second;
+  if (++transfer.retries > m_transferRetries) {
+    m_outgoing.erase(found);
+    m_transfersAbandoned++;
+    return;
+  }
+  transfer.sender.Reset();
+  SendOffer(neighbor, dataId);
+}
+
+void RhpmanApp::SendStatus(uint32_t neighbor, uint32_t dataId, bool complete) {
+  TransferHeader status;
+  status.SetKind(TransferHeader::STATUS);
+  status.SetSender(m_index);
+  status.SetRecipient(neighbor);
+  status.SetDataId(dataId);
+  auto partial = m_partialItems.find(dataId);
+  if (complete) {
+    status.SetIndex(GetFragmentCount(dataId));
+  } else if (partial != m_partialItems.end()) {
+    status.SetIndex(partial->second.receiver.GetEnd());
+    status.SetMissing(partial->second.receiver.GetMissing());
+    partial->second.unreported = 0;
+  }
+  Ptr<Packet> packet = Create<Packet>();
+  packet->AddHeader(status);
+  SendBroadcast(packet);
+}
+
+void RhpmanApp::ReceiveTransfer(Ptr<Packet> packet) {
+  TransferHeader transfer;
+  packet->RemoveHeader(transfer);
+  const uint32_t dataId = transfer.GetDataId();
+  if (transfer.GetKind() == TransferHeader::OFFER) PeerHolds(transfer.GetSender(), dataId);
+  if (transfer.GetRecipient() != m_index) {
+    // The overheard sender of a complete status no longer lacks the data.
+    if (transfer.GetKind() == TransferHeader::STATUS &&
+        transfer.GetIndex() == GetFragmentCount(dataId) && transfer.GetMissing().IsEmpty()) {
+      PeerHolds(transfer.GetSender(), dataId);
+    }
+    return;
+  }
+  switch (transfer.GetKind()) {
+    case TransferHeader::OFFER:
+      // Data which is held or not wanted is reported as complete.
+      SendStatus(
+          transfer.GetSender(),
+          dataId,
+          m_engine->HasData(m_index, dataId) || IsRedundant(dataId));
+      break;
+    case TransferHeader::STATUS:
+      ReceiveStatus(transfer);
+      break;
+    case TransferHeader::FRAGMENT:
+      ReceiveFragment(transfer);
+      break;
+  }
+}
+
+void RhpmanApp::ReceiveStatus(const TransferHeader& status) {
+  auto found = m_outgoing.find(TransferKey(status.GetSender(), status.GetDataId()));
+  if (found == m_outgoing.end()) return;
+  OutgoingTransfer& transfer = found->second;
+  std::vector<uint32_t> send;
+  if (!transfer.sender.ReceiveStatus(status.GetIndex(), status.GetMissing(), send)) return;
+  transfer.retries = 0;
+  Simulator::Cancel(transfer.timer);
+  if (transfer.sender.IsComplete()) {
+    PeerHolds(status.GetSender(), status.GetDataId());
+    m_outgoing.erase(found);
+    m_transfersCompleted++;
+    m_dataSent++;
+    return;
+  }
+  transfer.sender.Advance(send);
+  SendFragments(status.GetSender(), status.GetDataId(), send);
+  transfer.timer = Simulator::Schedule(
+      m_transferTimeout,
+      &RhpmanApp::TransferTimeout,
+      this,
+      status.GetSender(),
+      status.GetDataId());
+}
+
+/// A status is sent once the item is complete, when a fragment skipped over
+/// others which may have been lost, and otherwise every half window, so that
+/// the sender can keep its window full.
+void RhpmanApp::ReceiveFragment(const TransferHeader& fragment) {
+  const uint32_t dataId = fragment.GetDataId();
+  if (m_engine->HasData(m_index, dataId) || IsRedundant(dataId)) return;
+  auto found = m_partialItems.find(dataId);
+  if (found == m_partialItems.end()) {
+    if (m_partialItems.size() >= kMaxPartialItems) {
+      auto oldest = std::min_element(
+          m_partialItems.begin(),
+          m_partialItems.end(),
+          [](const std::pair<const uint32_t, PartialItem>& a,
+             const std::pair<const uint32_t, PartialItem>& b) {
+            return a.second.updated < b.second.updated;
+          });
+      m_partialItems.erase(oldest);
+    }
+    PartialItem partial{FragmentReceiver(fragment.GetFragments()), 0, Simulator::Now()};
+    found = m_partialItems.emplace(dataId, partial).first;
+  }
+
+  PartialItem& partial = found->second;
+  if (partial.receiver.GetFragments() != fragment.GetFragments()) return;
+  const bool gap = fragment.GetIndex() > partial.receiver.GetEnd();
+  if (!partial.receiver.Receive(fragment.GetIndex())) return;
+  partial.unreported++;
+  partial.updated = Simulator::Now();
+  if (partial.receiver.IsComplete()) {
+    m_partialItems.erase(found);
+    StoreItem(fragment.GetSender(), dataId);
+    SendStatus(fragment.GetSender(), dataId, true);
+  } else if (gap || 2 * partial.unreported >= m_transferWindow) {
+    SendStatus(fragment.GetSender(), dataId, false);
+  }
+}
+
+/// The whole set of delivered data is sent when a neighbor which may not have
+/// it yet came into range. Otherwise only the data delivered since the last
+/// anti-packet is sent, if there is any. Sets are never pruned, but they are
+/// bitmaps of small ids, so they stay compact.
+void RhpmanApp::SendAcks() {
+  if (m_delivered.IsEmpty()) return;
+  const uint32_t* neighbors = m_engine->GetNeighbors(m_index);
+  const uint32_t count = m_engine->GetNeighborCount(m_index);
+  if (count == 0) return;
+  const bool newNeighbor =
+      !std::includes(m_ackNeighbors.begin(), m_ackNeighbors.end(), neighbors, neighbors + count);
+  if (!newNeighbor && m_delivered.GetSize() == m_acked.GetSize()) return;
+  m_ackNeighbors.assign(neighbors, neighbors + count);
+
+  AckHeader ack;
+  ack.SetSender(m_index);
+  if (newNeighbor) {
+    ack.SetDelivered(m_delivered);
+  } else {
+    DataSet added = m_delivered;
+    added.Subtract(m_acked);
+    ack.SetDelivered(added);
+  }
+  m_acked = m_delivered;
+  Ptr<Packet> packet = Create<Packet>();
+  packet->AddHeader(ack);
+  Broadcast(packet);
+  m_acksSent++;
+}
+
+/// Replicas of delivered data are dropped, except by the owner of the data
+/// and by the nodes whose copy reached the destination, or which are a
+/// destination of the data now.
+void RhpmanApp::ReceiveAcks(const AckHeader& ack) {
+  const size_t known = m_delivered.GetSize();
+  m_delivered.UnionWith(ack.GetDelivered());
+  if (m_delivered.GetSize() == known) return;
+
+  m_dropped.clear();
+  for (uint32_t dataId : m_engine->GetStorage(m_index)) {
+    if (int32_t(dataId) != m_dataId && m_delivered.Contains(dataId) &&
+        !m_destinationCopies.Contains(dataId) && !IsDestination(dataId)) {
+      m_dropped.push_back(dataId);
+    }
+  }
+  for (uint32_t dataId : m_dropped) {
+    m_engine->RemoveData(m_index, dataId);
+    m_buffer.Remove(dataId);
+    m_replicasPurged++;
+  }
+}
+
+void RhpmanApp::ReceivePiggyback(const PiggybackTrailer& trailer) {
+  const uint32_t node = trailer.GetProfile().GetNode();
+  if (node == m_index) return;
+  ReceiveProfile(trailer.GetProfile());
+  // As with election messages, a newer round only means that its tick has not
+  // run here yet, so its election is started early.
+  if (trailer.GetElectionRound() > m_electionRound) StartElection(trailer.GetElectionRound());
+}
+
+/// The fitness of a node to hold replicas is the probability that it
+/// delivers data which belongs to its current partition, rounded as it is
+/// sent, so that every node compares the same values.
+float RhpmanApp::GetFitness() const {
+  const double probability =
+      m_engine->GetDeliveryProbability(m_index, m_engine->GetPartition(m_index));
+  return DecodeProbability(EncodeProbability(probability));
+}
+
+bool RhpmanApp::BeatsBestCandidate(float fitness, uint32_t candidate) const {
+  return fitness > m_electionBestFitness ||
+         (fitness == m_electionBestFitness && candidate < m_electionBest);
+}
+
+void RhpmanApp::ReceiveElection(ElectionHeader election) {
+  const uint32_t candidate = election.GetCandidate();
+  const uint32_t round = election.GetRound();
+  if (candidate == m_index || round < m_electionRound) return;
+  // Clocks agree, so a newer round only means that its tick has not run yet.
+  if (round > m_electionRound) StartElection(round);
+  if (candidate == m_electionBest) {
+    OverheardRebroadcast(MessageType::ELECTION, candidate, round);
+    return;
+  }
+  if (!BeatsBestCandidate(election.GetFitness(), candidate)) return;
+
+  // The previous best candidate is dominated, so it is no longer forwarded.
+  auto pending =
+      m_pendingRebroadcasts.find(RebroadcastKey(MessageType::ELECTION, m_electionBest, round));
+  if (pending != m_pendingRebroadcasts.end()) {
+    Simulator::Cancel(pending->second.event);
+    m_pendingRebroadcasts.erase(pending);
+    m_rebroadcastsSuppressed++;
+  }
+  m_electionBest = candidate;
+  m_electionBestFitness = election.GetFitness();
+  m_electionConverged = Simulator::Now();
+  if (election.GetHops() == 0) return;
+
+  election.SetHops(election.GetHops() - 1);
+  Ptr<Packet> packet = Create<Packet>();
+  packet->AddHeader(election);
+  ScheduleRebroadcast(MessageType::ELECTION, candidate, round, packet);
+}
+
+double RhpmanApp::GetDeliveryProbability(uint32_t neighbor, uint32_t partition) {
+  if (partition >= m_engine->GetConfig().GetPartitions()) return 0.0;
+  return GetDeliveryProbabilities(neighbor)[partition];
+}
+
+/// A neighbor which has not sent a profile yet is cached with no chance of
+/// delivering anything, until its first profile invalidates the entry.
+const float* RhpmanApp::GetDeliveryProbabilities(uint32_t neighbor) {
+  const uint64_t epoch = m_engine->GetEpoch();
+  const float* probability = m_probabilities.Lookup(neighbor, epoch);
+  if (probability != nullptr) return probability;
+
+  const RhpmanConfig& config = m_engine->GetConfig();
+  const uint32_t partitions = config.GetPartitions();
+  float* fill = m_probabilities.Insert(neighbor, epoch, partitions);
+  auto found = m_peers.find(neighbor);
+  if (found == m_peers.end()) {
+    std::fill_n(fill, partitions, 0.0f);
+    return fill;
+  }
+  const PeerProfile& peer = found->second;
+  const float base = config.wcdc * peer.degreeConnectivity;
+  for (uint32_t p = 0; p < partitions; p++) {
+    fill[p] = base + float(config.wcol) * peer.colocation[p];
+  }
+  return fill;
+}
+
 void RhpmanAppHelper::SetAttribute(std::string name, const AttributeValue& value) {
+  TypeId::AttributeInformation info;
+  if (RhpmanEngine::GetTypeId().LookupAttributeByName(name, &info)) {
+    m_engine->SetAttribute(name, value);
+    return;
+  }
   m_factory.Set(name, value);
 }
 
+void RhpmanAppHelper::SetArea(const SimulationArea& area, uint32_t rows, uint32_t cols) {
+  m_engine->SetArea(area, rows, cols);
+}
+
 void RhpmanAppHelper::SetDataOwners(uint32_t num) { m_dataOwners = num; }
 
 ApplicationContainer RhpmanAppHelper::Install(NodeContainer nodes) {
@@ -201,8 +1678,9 @@ ApplicationContainer RhpmanAppHelper::Install(Ptr<Node> node) const {
 }
 
 Ptr<Application> RhpmanAppHelper::createAndInstallApp(Ptr<Node> node) const {
-  Ptr<Application> app = m_factory.Create<Application>();
+  Ptr<RhpmanApp> app = m_factory.Create<RhpmanApp>();
   node->AddApplication(app);
+  app->SetEngine(m_engine);
   return app;
 }
 
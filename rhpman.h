@@ -26,17 +26,31 @@
 
 #include <bits/stdint-uintn.h>
 #include <map>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 #include "ns3/application-container.h"
 #include "ns3/application.h"
 #include "ns3/applications-module.h"
 #include "ns3/attribute.h"
 #include "ns3/core-module.h"
+#include "ns3/data-rate.h"
 #include "ns3/node-container.h"
 #include "ns3/object-base.h"
 #include "ns3/object-factory.h"
 #include "ns3/socket.h"
 
+#include "bulk-transfer.h"
+#include "decision-kernel.h"
+#include "messages.h"
+#include "probability-cache.h"
+#include "rhpman-engine.h"
+#include "seen-filter.h"
+#include "simulation-area.h"
+#include "timer-wheel.h"
+#include "transmit-buffer.h"
+
 namespace rhpman {
 
 using namespace ns3;
@@ -46,9 +60,12 @@ using namespace ns3;
 ///     If this app instance is a data owner, its role will be set to
 ///     REPLICATING and its DataId will be non-negative.
 ///     App instances which are not data owners will have negative a DataId.
+///
+///     The RHPMAN state of the node is owned by a RhpmanEngine shared by all
+///     apps of the simulation; the app only holds its index into the engine.
 class RhpmanApp : public Application {
  public:
-  enum Role { NON_REPLICATING = 0, REPLICATING };
+  using Role = RhpmanEngine::Role;
 
   /// \brief Identifies the lifecycle state of this app.
   enum class State { NOT_STARTED = 0, RUNNING, STOPPED };
@@ -58,17 +75,113 @@ class RhpmanApp : public Application {
   RhpmanApp()
       : m_state(State::NOT_STARTED),
         m_role(Role::NON_REPLICATING),
-        m_forwardingThreshold(0.4),
-        m_carryingThreshold(0.6),
-        m_wcdc(0.5),
-        m_wcol(0.5),
-        m_neighborhoodHops(2),
-        m_electionNeighborhoodHops(4),
-        m_profileDelay(),
-        m_storage(),
-        m_degreeConnectivity(),
+        m_dataId(-1),
+        m_dataSize(0),
+        m_port(5000),
         m_socket(0),
-        m_dataId(-1){};
+        m_engine(0),
+        m_index(0),
+        m_fullProfileInterval(8),
+        m_aggregateProfiles(false),
+        m_adaptiveProfileDelay(false),
+        m_maxProfileDelay(Seconds(60)),
+        m_churnThreshold(0.2),
+        m_profileDelay(),
+        m_lastPartition(0),
+        m_sentVersion(0),
+        m_profileSent(false),
+        m_baseline(),
+        m_baselineNeighbors(),
+        m_deltasSinceFull(0),
+        m_profilesSent(0),
+        m_deltaProfilesSent(0),
+        m_profileBytesSent(0),
+        m_profilesSuppressed(0),
+        m_profileGaps(0),
+        m_profilesPiggybacked(0),
+        m_summarySequence(0),
+        m_summariesSent(0),
+        m_messagesForwarded(0),
+        m_startJitter(Seconds(1)),
+        m_broadcastJitter(MilliSeconds(10)),
+        m_rebroadcastThreshold(3),
+        m_random(CreateObject<UniformRandomVariable>()),
+        m_pendingRebroadcasts(),
+        m_rebroadcastsSuppressed(0),
+        m_peers(),
+        m_probabilities(),
+        m_seenFilterCapacity(1024),
+        m_seen(),
+        m_electionPeriod(Seconds(120)),
+        m_electionBackoff(Seconds(1)),
+        m_electionTimeout(Seconds(5)),
+        m_electionRound(0),
+        m_electionBest(0),
+        m_electionBestFitness(0),
+        m_electionStart(),
+        m_electionConverged(),
+        m_electionMessages(0),
+        m_announcementsSuppressed(0),
+        m_electionsHeld(0),
+        m_electionConvergence(),
+        m_reconcileOnContact(false),
+        m_contacts(),
+        m_peerMissing(),
+        m_peerHeld(),
+        m_reconcileBytesSent(0),
+        m_reconciliations(0),
+        m_reconcileRetries(0),
+        m_reconcileTimeouts(0),
+        m_dataSequence(0),
+        m_dataSent(0),
+        m_maxBatchSize(0),
+        m_batchDelay(MilliSeconds(2)),
+        m_batch(),
+        m_batchSize(0),
+        m_batchEvent(),
+        m_batchesSent(0),
+        m_fragmentSize(1024),
+        m_transferWindow(16),
+        m_transferTimeout(MilliSeconds(100)),
+        m_transferRetries(3),
+        m_outgoing(),
+        m_partialItems(),
+        m_fragmentsSent(0),
+        m_transfersCompleted(0),
+        m_transfersAbandoned(0),
+        m_contactAwareScheduling(false),
+        m_linkRate(DataRate("1Mbps")),
+        m_transferWanted(),
+        m_contactCandidates(),
+        m_contactBudget(),
+        m_itemsDeferred(0),
+        m_dataReceived(0),
+        m_decisions(),
+        m_kernelConnectivity(),
+        m_kernelColocation(),
+        m_kernelHome(),
+        m_replicaTtl(),
+        m_maxTransfersPerTick(0),
+        m_buffer(),
+        m_replicasExpired(0),
+        m_transferIndex(),
+        m_dropped(),
+        m_antiPackets(false),
+        m_delivered(),
+        m_acked(),
+        m_destinationCopies(),
+        m_ackNeighbors(),
+        m_acksSent(0),
+        m_replicasPurged(0),
+        m_profileTimer(),
+        m_dataTimer(),
+        m_electionTimer(),
+        m_announceTimer(),
+        m_electionTimeoutTimer(){};
+
+  /// \brief Registers this app's node with the engine.
+  ///     Must be called once, after the app has been added to its node.
+  void SetEngine(Ptr<RhpmanEngine> engine);
 
   Ptr<Socket> GetSocket() const;
   Role GetRole() const;
@@ -77,32 +190,427 @@ class RhpmanApp : public Application {
     return m_dataId;
   }
 
+  /// \brief Gets the current time between profile exchanges of this app.
+  Time GetProfileDelay() const { return m_profileDelay; }
+
+  /// \brief Gets the number of profiles this app has broadcast.
+  uint64_t GetProfilesSent() const { return m_profilesSent; }
+
+  /// \brief Gets the number of profiles this app has broadcast as deltas.
+  uint64_t GetDeltaProfilesSent() const { return m_deltaProfilesSent; }
+
+  /// \brief Gets the number of bytes of profiles this app has broadcast.
+  uint64_t GetProfileBytesSent() const { return m_profileBytesSent; }
+
+  /// \brief Gets the number of profile exchanges skipped because the profile
+  ///     had not changed since it was last broadcast.
+  uint64_t GetProfilesSuppressed() const { return m_profilesSuppressed; }
+
+  /// \brief Gets the number of delta profiles dropped because the full
+  ///     profile they were based on had not been received.
+  uint64_t GetProfileGaps() const { return m_profileGaps; }
+
+  /// \brief Gets the number of profiles this app has attached to outgoing
+  ///     data instead of broadcasting them.
+  uint64_t GetProfilesPiggybacked() const { return m_profilesPiggybacked; }
+
+  /// \brief Gets the number of partition summaries this app has sent as a
+  ///     cluster head.
+  uint64_t GetSummariesSent() const { return m_summariesSent; }
+
+  /// \brief Gets the number of profiles and summaries this app has forwarded
+  ///     for other nodes.
+  uint64_t GetMessagesForwarded() const { return m_messagesForwarded; }
+
+  /// \brief Gets the number of profiles and summaries this app did not
+  ///     forward because enough neighbors were overheard forwarding them.
+  uint64_t GetRebroadcastsSuppressed() const { return m_rebroadcastsSuppressed; }
+
+  /// \brief Gets the number of election announcements this app has sent or
+  ///     forwarded.
+  uint64_t GetElectionMessages() const { return m_electionMessages; }
+
+  /// \brief Gets the number of times this app did not announce itself in an
+  ///     election because it already knew of a better candidate.
+  uint64_t GetAnnouncementsSuppressed() const { return m_announcementsSuppressed; }
+
+  /// \brief Gets the number of elections this app has completed.
+  uint64_t GetElectionsHeld() const { return m_electionsHeld; }
+
+  /// \brief Gets the total time from the start of each completed election to
+  ///     the last change of its winner, as seen by this app.
+  Time GetElectionConvergenceTime() const { return m_electionConvergence; }
+
+  /// \brief Gets the number of bytes of reconcile messages this app has sent.
+  uint64_t GetReconcileBytesSent() const { return m_reconcileBytesSent; }
+
+  /// \brief Gets the number of contacts after which this app learned which
+  ///     data the other node lacks.
+  uint64_t GetReconciliations() const { return m_reconciliations; }
+
+  /// \brief Gets the number of reconcile tables this app could not decode.
+  uint64_t GetReconcileRetries() const { return m_reconcileRetries; }
+
+  /// \brief Gets the number of reconcile requests this app sent again because
+  ///     no reply came by its next tick.
+  uint64_t GetReconcileTimeouts() const { return m_reconcileTimeouts; }
+
+  /// \brief Gets the number of data items this app has sent.
+  uint64_t GetDataSent() const { return m_dataSent; }
+
+  /// \brief Gets the number of datagrams this app has sent data items in.
+  uint64_t GetBatchesSent() const { return m_batchesSent; }
+
+  /// \brief Gets the number of fragments of large data items this app has
+  ///     sent, including those sent again.
+  uint64_t GetFragmentsSent() const { return m_fragmentsSent; }
+
+  /// \brief Gets the number of transfers of large data items this app has
+  ///     completed.
+  uint64_t GetTransfersCompleted() const { return m_transfersCompleted; }
+
+  /// \brief Gets the number of transfers this app gave up on because the
+  ///     recipient stopped answering; they resume on a later contact.
+  uint64_t GetTransfersAbandoned() const { return m_transfersAbandoned; }
+
+  /// \brief Gets the number of times this app held an item back from a
+  ///     neighbor because it would not fit in their contact.
+  uint64_t GetItemsDeferred() const { return m_itemsDeferred; }
+
+  /// \brief Gets the number of data items this app has received.
+  uint64_t GetDataReceived() const { return m_dataReceived; }
+
+  /// \brief Gets the number of replicas this app dropped because their
+  ///     ReplicaTtl ran out.
+  uint64_t GetReplicasExpired() const { return m_replicasExpired; }
+
+  /// \brief Gets the number of anti-packets this app has sent.
+  uint64_t GetAcksSent() const { return m_acksSent; }
+
+  /// \brief Gets the number of replicas this app dropped because they were
+  ///     already delivered.
+  uint64_t GetReplicasPurged() const { return m_replicasPurged; }
+
+  /// \brief Gets the probability that a neighbor delivers data which belongs
+  ///     to a partition, from the last profile received from the neighbor.
+  ///     Probabilities are cached per neighbor until the next epoch, or until
+  ///     the neighbor sends a new profile.
+  ///
+  /// \return double The probability, or 0 if no profile was received from
+  ///     the neighbor.
+  double GetDeliveryProbability(uint32_t neighbor, uint32_t partition);
+
+  /// \brief Gets the probability that a neighbor delivers data which belongs
+  ///     to each partition, as for GetDeliveryProbability.
+  ///
+  /// \return const float* One probability per partition.
+  const float* GetDeliveryProbabilities(uint32_t neighbor);
+
+  /// \brief Gets the probability cache lookups which found an entry.
+  uint64_t GetProbabilityCacheHits() const { return m_probabilities.GetHits(); }
+
+  /// \brief Gets the probability cache lookups which had to compute an entry.
+  uint64_t GetProbabilityCacheMisses() const { return m_probabilities.GetMisses(); }
+
  private:
   // Application lifecycle methods.
 
   void StartApplication() override;
   void StopApplication() override;
+  void DoDispose() override;
+
+  // Timer handlers.
+
+  void ProfileTick();
+  void DataTick();
+  void AdaptProfileDelay();
+  void ElectionTick();
+  void StartElection(uint32_t round);
+  void AnnounceCandidacy();
+  void ElectionTimeout();
+  void CancelTimers();
+
+  // Socket handlers.
+
+  void HandleRead(Ptr<Socket> socket);
 
   // RHPMAN Scheme methods.
 
-  void UpdateProfile();
+  bool UpdateProfile();
+  ProfileHeader NextProfile(bool allowDelta);
   void ExchangeProfiles();
+  void ForwardProfile(ProfileHeader profile);
+  void Broadcast(Ptr<Packet> packet);
+  void SendBroadcast(Ptr<Packet> packet);
+  void ScheduleRebroadcast(MessageType type, uint32_t origin, uint32_t version, Ptr<Packet> packet);
+  void OverheardRebroadcast(MessageType type, uint32_t origin, uint32_t version);
+  void Rebroadcast(MessageType type, uint32_t origin, uint32_t version);
+  uint8_t GetForwardHops() const;
+  uint8_t GetElectionHops() const;
+  bool IsClusterHead() const;
+  void SendSummary();
+  void ReceiveSummary(SummaryHeader summary);
+  void ReceiveProfile(const ProfileHeader& profile);
+  void ExpirePeers();
+  bool BaselineCoversNeighbors() const;
+  void UpdateContacts();
+  void RequestReconcile(uint32_t neighbor, uint32_t cells);
+  void SendReconcile(const ReconcileHeader& reconcile);
+  void ReceiveReconcile(const ReconcileHeader& reconcile);
+  Time GetExpiry(uint32_t dataId) const;
+  void ExpireReplicas();
+  bool PeerLacks(uint32_t neighbor, uint32_t dataId) const;
+  void PeerHolds(uint32_t neighbor, uint32_t dataId);
+  void ComputeDecisions();
+  void TransferData();
+  void ScheduleContacts();
+  uint32_t GetItemCost(uint32_t dataId) const;
+  uint32_t GetTransferCost(uint32_t dataId, const FragmentSender& sender) const;
+  void SendData(uint32_t neighbor, uint32_t dataId, bool forward, bool carry);
+  void FlushBatch();
+  void ReceiveData(Ptr<Packet> packet);
+  void StoreItem(uint32_t sender, uint32_t dataId);
+  bool IsRedundant(uint32_t dataId) const;
+  uint32_t GetFragmentCount(uint32_t dataId) const;
+  void StartTransfer(uint32_t neighbor, uint32_t dataId);
+  void SendOffer(uint32_t neighbor, uint32_t dataId);
+  void SendFragments(uint32_t neighbor, uint32_t dataId, const std::vector<uint32_t>& indices);
+  void TransferTimeout(uint32_t neighbor, uint32_t dataId);
+  void SendStatus(uint32_t neighbor, uint32_t dataId, bool complete);
+  void ReceiveTransfer(Ptr<Packet> packet);
+  void ReceiveStatus(const TransferHeader& status);
+  void ReceiveFragment(const TransferHeader& fragment);
+  void ReceivePiggyback(const PiggybackTrailer& trailer);
+  bool IsDestination(uint32_t dataId) const;
+  void SendAcks();
+  void ReceiveAcks(const AckHeader& ack);
+  float GetFitness() const;
+  bool BeatsBestCandidate(float fitness, uint32_t candidate) const;
+  void ReceiveElection(ElectionHeader election);
+
+  /// \brief The last profile received from a peer, and the last full profile
+  ///     that later deltas from the peer are based on.
+  struct PeerProfile {
+    uint32_t version;
+    uint32_t storageVersion;
+    uint32_t partition;
+    float degreeConnectivity;
+    std::vector<float> colocation;
+    uint32_t baseVersion;
+    std::vector<float> baseline;
+    Time heard;
+
+    /// \brief Makes the full profile of the peer from what is known of it.
+    ProfileHeader ToHeader(uint32_t node) const;
+  };
+
+  /// \brief A message which is waiting to be forwarded, and the number of
+  ///     copies of it overheard in the meantime.
+  struct PendingRebroadcast {
+    uint32_t copies;
+    EventId event;
+    Ptr<Packet> packet;
+  };
+  using RebroadcastKey = std::tuple<MessageType, uint32_t, uint32_t>;
+
+  /// \brief A large data item being sent to a neighbor.
+  struct OutgoingTransfer {
+    FragmentSender sender;
+    // Timeouts since the neighbor last answered.
+    uint32_t retries;
+    EventId timer;
+  };
+  // The neighbor and the data id of a transfer.
+  using TransferKey = std::pair<uint32_t, uint32_t>;
+
+  /// \brief A large data item being received, from any number of senders.
+  struct PartialItem {
+    FragmentReceiver receiver;
+    // Fragments received since the last status was sent.
+    uint32_t unreported;
+    Time updated;
+  };
+
+  /// \brief An item which could be sent to a neighbor during their contact.
+  struct ContactCandidate {
+    float density;
+    uint32_t neighbor;
+    uint32_t item;
+    uint32_t cost;
+  };
+
+  /// The bytes added to each datagram below RHPMAN: the 802.11 MAC header
+  /// and FCS, LLC/SNAP, and the IPv4 and UDP headers.
+  static constexpr uint32_t kDatagramOverhead = 64;
+
+  /// The number of partly received items a node keeps so that their
+  /// transfers can resume; beyond it, the least recently updated is dropped.
+  static constexpr uint32_t kMaxPartialItems = 64;
+
+  /// Bits of the seen filter per message it remembers, which keeps its false
+  /// positive rate below 0.1%.
+  static constexpr uint32_t kSeenFilterBitsPerMessage = 16;
+
+  /// The number of maximum profile delays after which a peer which has not
+  /// been heard from is forgotten.
+  static constexpr uint32_t kPeerLifetime = 3;
 
   // Member fields.
 
   State m_state;
+  // Initial role and data; only used to register the node with the engine.
   Role m_role;
-  double m_forwardingThreshold;
-  double m_carryingThreshold;
-  double m_wcdc;
-  double m_wcol;
-  uint32_t m_neighborhoodHops;
-  uint32_t m_electionNeighborhoodHops;
-  Time m_profileDelay;
-  std::vector<uint32_t> m_storage;
-  std::map<Time, uint32_t> m_degreeConnectivity;
-  Ptr<Socket> m_socket;
   int32_t m_dataId;
+  uint32_t m_dataSize;
+  uint16_t m_port;
+  Ptr<Socket> m_socket;
+  Ptr<RhpmanEngine> m_engine;
+  uint32_t m_index;
+
+  // Profile exchange.
+
+  uint32_t m_fullProfileInterval;
+  bool m_aggregateProfiles;
+  bool m_adaptiveProfileDelay;
+  Time m_maxProfileDelay;
+  double m_churnThreshold;
+  Time m_profileDelay;
+  uint32_t m_lastPartition;
+  uint32_t m_sentVersion;
+  bool m_profileSent;
+  // The last full profile sent, and the neighbors the node had at the time.
+  ProfileHeader m_baseline;
+  std::vector<uint32_t> m_baselineNeighbors;
+  uint32_t m_deltasSinceFull;
+  uint64_t m_profilesSent;
+  uint64_t m_deltaProfilesSent;
+  uint64_t m_profileBytesSent;
+  uint64_t m_profilesSuppressed;
+  uint64_t m_profileGaps;
+  uint64_t m_profilesPiggybacked;
+  uint32_t m_summarySequence;
+  uint64_t m_summariesSent;
+  uint64_t m_messagesForwarded;
+
+  // Broadcast scheduling.
+
+  Time m_startJitter;
+  Time m_broadcastJitter;
+  uint32_t m_rebroadcastThreshold;
+  Ptr<UniformRandomVariable> m_random;
+  std::map<RebroadcastKey, PendingRebroadcast> m_pendingRebroadcasts;
+  uint64_t m_rebroadcastsSuppressed;
+
+  // What is known about peers.
+
+  std::map<uint32_t, PeerProfile> m_peers;
+  ProbabilityCache m_probabilities;
+  // The multi-hop messages which were already forwarded.
+  uint32_t m_seenFilterCapacity;
+  SeenFilter m_seen;
+
+  // Election state.
+
+  Time m_electionPeriod;
+  Time m_electionBackoff;
+  Time m_electionTimeout;
+  uint32_t m_electionRound;
+  // The best candidate known in the current round.
+  uint32_t m_electionBest;
+  float m_electionBestFitness;
+  Time m_electionStart;
+  Time m_electionConverged;
+  uint64_t m_electionMessages;
+  uint64_t m_announcementsSuppressed;
+  uint64_t m_electionsHeld;
+  Time m_electionConvergence;
+
+  // Storage reconciliation.
+
+  bool m_reconcileOnContact;
+  // The direct neighbors of the node at its last tick, sorted by index.
+  std::vector<uint32_t> m_contacts;
+  // The data which each current contact is known to lack.
+  std::map<uint32_t, DataSet> m_peerMissing;
+  // The data which each current contact was overheard to hold, when the
+  // node does not reconcile.
+  std::map<uint32_t, DataSet> m_peerHeld;
+  uint64_t m_reconcileBytesSent;
+  uint64_t m_reconciliations;
+  uint64_t m_reconcileRetries;
+  uint64_t m_reconcileTimeouts;
+
+  // Data transfer.
+
+  uint32_t m_dataSequence;
+  uint64_t m_dataSent;
+  uint32_t m_maxBatchSize;
+  Time m_batchDelay;
+  // The data items waiting to be sent together, and their size in bytes.
+  std::vector<DataHeader> m_batch;
+  uint32_t m_batchSize;
+  EventId m_batchEvent;
+  uint64_t m_batchesSent;
+
+  // Transfers of large data items.
+
+  uint32_t m_fragmentSize;
+  uint32_t m_transferWindow;
+  Time m_transferTimeout;
+  uint32_t m_transferRetries;
+  std::map<TransferKey, OutgoingTransfer> m_outgoing;
+  std::map<uint32_t, PartialItem> m_partialItems;
+  uint64_t m_fragmentsSent;
+  uint64_t m_transfersCompleted;
+  uint64_t m_transfersAbandoned;
+
+  // Contact-aware scheduling.
+
+  bool m_contactAwareScheduling;
+  DataRate m_linkRate;
+  // Whether each neighbor should be sent each stored item on this tick,
+  // indexed by neighbor * items + item.
+  std::vector<uint8_t> m_transferWanted;
+  std::vector<ContactCandidate> m_contactCandidates;
+  // The bytes which each neighbor can still be sent before it moves away.
+  std::vector<double> m_contactBudget;
+  uint64_t m_itemsDeferred;
+  uint64_t m_dataReceived;
+  DecisionMasks m_decisions;
+  // Scratch space for the inputs of the decision kernel.
+  std::vector<float> m_kernelConnectivity;
+  std::vector<float> m_kernelColocation;
+  std::vector<uint8_t> m_kernelHome;
+  Time m_replicaTtl;
+  uint32_t m_maxTransfersPerTick;
+  // The data held by the node, in the order it should be sent.
+  TransmitBuffer m_buffer;
+  uint64_t m_replicasExpired;
+  // Scratch space for TransferData, and for the replicas dropped from storage.
+  std::unordered_map<uint32_t, uint32_t> m_transferIndex;
+  std::vector<uint32_t> m_dropped;
+
+  // Anti-packets.
+
+  bool m_antiPackets;
+  // The data known to be delivered, and that set as of the last anti-packet.
+  DataSet m_delivered;
+  DataSet m_acked;
+  // The delivered data whose copy at this node is the one which reached its
+  // destination; these are kept wherever the node goes and whatever its role.
+  DataSet m_destinationCopies;
+  // The direct neighbors of the node when it last sent an anti-packet.
+  std::vector<uint32_t> m_ackNeighbors;
+  uint64_t m_acksSent;
+  uint64_t m_replicasPurged;
+
+  // Timers; all of these are held by the simulation's TimerWheel.
+
+  TimerWheel::Handle m_profileTimer;
+  TimerWheel::Handle m_dataTimer;
+  TimerWheel::Handle m_electionTimer;
+  TimerWheel::Handle m_announceTimer;
+  TimerWheel::Handle m_electionTimeoutTimer;
 };
 
 /// \brief Helper class to install the RhpmanApplication on a Node containers.
@@ -113,12 +621,24 @@ class RhpmanAppHelper {
  public:
   RhpmanAppHelper(uint32_t dataOwners = 0) : m_dataOwners(dataOwners) {
     m_factory.SetTypeId(RhpmanApp::GetTypeId());
+    m_engine = CreateObject<RhpmanEngine>();
     rand = CreateObject<UniformRandomVariable>();
   };
 
+  /// \brief Sets an attribute of the apps, or of the engine they share if it
+  ///     has an attribute of that name.
   void SetAttribute(std::string name, const AttributeValue& value);
   void SetDataOwners(uint32_t num);
 
+  /// \brief Sets the area that nodes move in, and its partitioning.
+  void SetArea(const SimulationArea& area, uint32_t rows, uint32_t cols);
+
+  Ptr<RhpmanEngine> GetEngine() const { return m_engine; }
+
+  /// \brief Drops the helper's reference to the engine, so that it may be
+  ///     freed before the end of the helper's own lifetime.
+  void ReleaseEngine() { m_engine = 0; }
+
   /// \brief Configures a RHPMAN application and installs it on each node.
   ApplicationContainer Install(NodeContainer nodes);
   ApplicationContainer Install(Ptr<Node> node) const;
@@ -127,6 +647,7 @@ class RhpmanAppHelper {
  private:
   Ptr<Application> createAndInstallApp(Ptr<Node> node) const;
   ObjectFactory m_factory;
+  Ptr<RhpmanEngine> m_engine;
   Ptr<UniformRandomVariable> rand;
   uint32_t m_dataOwners;
 };
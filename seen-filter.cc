@@ -0,0 +1,93 @@
+/// \file seen-filter.cc
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#include <inttypes.h>
+#include <algorithm>
+#include <cmath>
+
+#include "seen-filter.h"
+
+namespace rhpman {
+
+namespace {
+
+// SplitMix64 finalizer; spreads keys which differ in a few bits over the
+// whole word.
+uint64_t mix(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+}  // namespace
+
+SeenFilter::SeenFilter(uint32_t bits, uint32_t capacity)
+    : m_words(std::max<uint32_t>(1, (bits + 63) / 64)),
+      m_capacity(std::max<uint32_t>(1, capacity)),
+      m_hashes(0),
+      m_inserted(0),
+      m_current(m_words, 0),
+      m_previous(m_words, 0) {
+  // The number of hashes which minimizes false positives when the filter is
+  // full.
+  const double optimal = double(m_words) * 64 / m_capacity * std::log(2.0);
+  m_hashes = std::min<uint32_t>(16, std::max<uint32_t>(1, std::lround(optimal)));
+}
+
+// static
+uint64_t SeenFilter::MakeKey(uint8_t type, uint32_t origin, uint32_t sequence) {
+  return mix((uint64_t(origin) << 32 | sequence) ^ (uint64_t(type) << 56));
+}
+
+bool SeenFilter::Contains(uint64_t key) const {
+  return test(m_current.data(), key) || test(m_previous.data(), key);
+}
+
+void SeenFilter::Insert(uint64_t key) {
+  if (m_inserted == m_capacity) {
+    std::swap(m_current, m_previous);
+    std::fill(m_current.begin(), m_current.end(), 0);
+    m_inserted = 0;
+  }
+  // Probes use double hashing, from the key and a second mix of it.
+  const uint64_t bits = uint64_t(m_words) * 64;
+  const uint64_t h1 = key;
+  const uint64_t h2 = mix(key) | 1;
+  for (uint32_t i = 0; i < m_hashes; i++) {
+    const uint64_t bit = (h1 + i * h2) % bits;
+    m_current[bit / 64] |= uint64_t(1) << (bit % 64);
+  }
+  m_inserted++;
+}
+
+void SeenFilter::Clear() {
+  std::fill(m_current.begin(), m_current.end(), 0);
+  std::fill(m_previous.begin(), m_previous.end(), 0);
+  m_inserted = 0;
+}
+
+bool SeenFilter::test(const uint64_t* filter, uint64_t key) const {
+  const uint64_t bits = uint64_t(m_words) * 64;
+  const uint64_t h1 = key;
+  const uint64_t h2 = mix(key) | 1;
+  for (uint32_t i = 0; i < m_hashes; i++) {
+    const uint64_t bit = (h1 + i * h2) % bits;
+    if (!((filter[bit / 64] >> (bit % 64)) & 1)) return false;
+  }
+  return true;
+}
+
+}  // namespace rhpman
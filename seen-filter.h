@@ -0,0 +1,72 @@
+/// \file seen-filter.h
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+/// \brief Declares a fixed-size filter of the multi-hop messages a node has
+///     already seen.
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef __seen_filter_h
+#define __seen_filter_h
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <vector>
+
+namespace rhpman {
+
+/// \brief Remembers which messages were seen, as a pair of Bloom filters.
+///     Keys are inserted into the current filter, and looked up in both.
+///     Once the current filter holds its capacity of keys, it becomes the
+///     previous filter, and the old previous filter is cleared to become the
+///     current one. A key is thus remembered for at least capacity later
+///     insertions, memory never grows, and both operations take a fixed
+///     number of bit probes. Like any Bloom filter, it may report a message
+///     which was never inserted as seen, but never the converse.
+class SeenFilter {
+ public:
+  /// \brief Makes a filter.
+  ///
+  /// \param bits The number of bits of each of the two filters; rounded up
+  ///     to a multiple of 64.
+  /// \param capacity The number of keys inserted before the filters rotate.
+  SeenFilter(uint32_t bits = 16384, uint32_t capacity = 1024);
+
+  /// \brief Makes a key identifying the message with a sequence number, or
+  ///     version, sent by an origin.
+  static uint64_t MakeKey(uint8_t type, uint32_t origin, uint32_t sequence);
+
+  bool Contains(uint64_t key) const;
+  void Insert(uint64_t key);
+  void Clear();
+
+  uint32_t GetHashes() const { return m_hashes; }
+
+  /// \brief Gets the memory used by the bits of both filters, in bytes.
+  size_t GetMemory() const { return 2 * m_words * sizeof(uint64_t); }
+
+ private:
+  bool test(const uint64_t* filter, uint64_t key) const;
+
+  uint32_t m_words;
+  uint32_t m_capacity;
+  uint32_t m_hashes;
+  uint32_t m_inserted;
+  // Both filters, current first; swapped on rotation.
+  std::vector<uint64_t> m_current;
+  std::vector<uint64_t> m_previous;
+};
+
+}  // namespace rhpman
+
+#endif
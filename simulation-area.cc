@@ -14,6 +14,7 @@
 /// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 /// PERFORMANCE OF THIS SOFTWARE.
 ///
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -84,6 +85,14 @@ std::vector<SimulationArea> SimulationArea::splitIntoGrid(int32_t x, int32_t y)
   return grid;
 }
 
+int32_t SimulationArea::gridIndexOf(double px, double py, int32_t x, int32_t y) const {
+  int32_t col = static_cast<int32_t>((px - minX()) / deltaX() * x);
+  int32_t row = static_cast<int32_t>((py - minY()) / deltaY() * y);
+  col = std::min(std::max(col, 0), x - 1);
+  row = std::min(std::max(row, 0), y - 1);
+  return col * y + row;
+}
+
 ns3::Ptr<ns3::GridPositionAllocator> SimulationArea::getGridPositionAllocator() const {
   auto alloc = ns3::CreateObject<ns3::GridPositionAllocator>();
   alloc->SetMinX(this->minX());
@@ -65,6 +65,17 @@ class SimulationArea {
     /// \return std::vector<SimulationArea>
     std::vector<SimulationArea> splitIntoGrid(int32_t x, int32_t y) const;
 
+    /// \brief Finds the cell of an x by y grid which contains a point.
+    ///     Cells are numbered in the same order as they are returned by
+    ///     splitIntoGrid. Points outside of the area map to the nearest cell.
+    ///
+    /// \param px The x coordinate of the point.
+    /// \param py The y coordinate of the point.
+    /// \param x The number of ways the area is divided horizontally.
+    /// \param y The number of ways the area is divided vertically.
+    /// \return int32_t The index of the cell.
+    int32_t gridIndexOf(double px, double py, int32_t x, int32_t y) const;
+
     /// \brief Get a Grid Position Allocator which is compatible with constant
     ///     position mobility models.
     ///
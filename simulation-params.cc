@@ -77,10 +77,35 @@ std::pair<SimulationParameters, bool> SimulationParameters::parse(int argc, char
   double optWcdc = 0.5;
   double optWcol = 0.5;
   double optProfileUpdateDelay = 6.0_seconds;
+  bool optAggregateProfiles = false;
+  bool optAdaptiveProfileDelay = false;
+  double optMaxProfileDelay = 60.0_seconds;
+  double optStartJitter = 1.0_seconds;
+  double optBroadcastJitter = 0.01_seconds;
+  uint32_t optRebroadcastThreshold = 3;
+  double optElectionPeriod = 120.0_seconds;
+  double optElectionBackoff = 1.0_seconds;
+  double optElectionTimeout = 5.0_seconds;
+  bool optReconcile = false;
+  uint32_t optStorageCapacity = 0;
+  double optReplicaTtl = 0.0_seconds;
+  uint32_t optMaxTransfersPerTick = 0;
+  bool optAntiPackets = false;
+  uint32_t optMaxBatchSize = 0;
+  double optBatchDelay = 0.002_seconds;
+  uint32_t optDataSize = 0;
+  uint32_t optFragmentSize = 1024;
+  uint32_t optTransferWindow = 16;
+  bool optContactAware = false;
 
   // Animation parameters.
   std::string animationTraceFilePath = "rhpman.xml";
 
+  // Process parameters.
+  bool optFastTeardown = false;
+  bool optUseArena = false;
+  uint32_t optWorkerThreads = 1;
+
   /* Setup commandline option for each simulation parameter. */
   CommandLine cmd;
   cmd.AddValue("run-time", "Simulation run time in seconds", optRuntime);
@@ -116,6 +141,86 @@ std::pair<SimulationParameters, bool> SimulationParameters::parse(int argc, char
       "profile-update-delay",
       "Number of seconds between profile updates",
       optProfileUpdateDelay);
+  cmd.AddValue(
+      "aggregate-profiles",
+      "Have a cluster head per partition forward the profiles of its members",
+      optAggregateProfiles);
+  cmd.AddValue(
+      "adaptive-profile-delay",
+      "Adapt the time between profile exchanges of each node to its neighborhood churn",
+      optAdaptiveProfileDelay);
+  cmd.AddValue(
+      "max-profile-delay",
+      "Longest number of seconds between profile exchanges when they adapt",
+      optMaxProfileDelay);
+  cmd.AddValue(
+      "start-jitter",
+      "Longest random delay in seconds of the first profile exchange of a node",
+      optStartJitter);
+  cmd.AddValue(
+      "broadcast-jitter",
+      "Longest random delay in seconds of each broadcast",
+      optBroadcastJitter);
+  cmd.AddValue(
+      "rebroadcast-threshold",
+      "Number of overheard copies of a message after which it is not forwarded; 0 disables",
+      optRebroadcastThreshold);
+  cmd.AddValue(
+      "election-period",
+      "Number of seconds between two replica holder elections",
+      optElectionPeriod);
+  cmd.AddValue(
+      "election-backoff",
+      "Longest number of seconds a candidate waits before announcing itself",
+      optElectionBackoff);
+  cmd.AddValue(
+      "election-timeout",
+      "Number of seconds after the start of an election at which its winner is decided",
+      optElectionTimeout);
+  cmd.AddValue(
+      "reconcile",
+      "Reconcile the storage of nodes when they come into contact",
+      optReconcile);
+  cmd.AddValue(
+      "storage-capacity",
+      "Number of replicas a node may hold besides its own data; 0 for no limit",
+      optStorageCapacity);
+  cmd.AddValue(
+      "replica-ttl",
+      "Number of seconds after which a node drops a replica it received; 0 keeps it",
+      optReplicaTtl);
+  cmd.AddValue(
+      "max-transfers-per-tick",
+      "Number of data items a node may send on each data tick; 0 for no limit",
+      optMaxTransfersPerTick);
+  cmd.AddValue(
+      "anti-packets",
+      "Gossip which data was delivered so that other holders drop their copies",
+      optAntiPackets);
+  cmd.AddValue(
+      "max-batch-size",
+      "Largest number of bytes of data items sent in one datagram; 0 sends each alone",
+      optMaxBatchSize);
+  cmd.AddValue(
+      "batch-delay",
+      "Number of seconds for which data items are collected before they are sent",
+      optBatchDelay);
+  cmd.AddValue(
+      "data-size",
+      "Size of each data item in bytes; items of 0 bytes are sent as their ids only",
+      optDataSize);
+  cmd.AddValue(
+      "fragment-size",
+      "Largest number of bytes of a data item sent in one datagram",
+      optFragmentSize);
+  cmd.AddValue(
+      "transfer-window",
+      "Largest number of fragments of a data item in flight at once",
+      optTransferWindow);
+  cmd.AddValue(
+      "contact-aware",
+      "Send only the data items that fit in the estimated duration of each contact",
+      optContactAware);
   cmd.AddValue("area-width", "Width of the simulation area in meters", optAreaWidth);
   cmd.AddValue("area-length", "Length of the simulation area in meters", optAreaLength);
   cmd.AddValue("grid-rows", "Number of rows in the partition grid", optRows);
@@ -151,6 +256,18 @@ std::pair<SimulationParameters, bool> SimulationParameters::parse(int argc, char
   cmd.AddValue("routing", "One of either 'DSDV' or 'AODV'", optRoutingProtocol);
   cmd.AddValue("wifi-radius", "The radius of connectivity for each node in meters", optWifiRadius);
   cmd.AddValue("animation-xml", "Output file path for NetAnim trace file", animationTraceFilePath);
+  cmd.AddValue(
+      "fast-teardown",
+      "Flush all outputs and exit without destroying the simulated objects; disables pcap traces",
+      optFastTeardown);
+  cmd.AddValue(
+      "arena",
+      "Allocate RHPMAN data id sets from an arena that is released at the end of the run",
+      optUseArena);
+  cmd.AddValue(
+      "worker-threads",
+      "Number of threads used for per-epoch RHPMAN computations; results do not depend on it",
+      optWorkerThreads);
   cmd.Parse(argc, argv);
 
   /* Parse the parameters. */
@@ -238,8 +355,31 @@ std::pair<SimulationParameters, bool> SimulationParameters::parse(int argc, char
   result.wcdc = optWcdc;
   result.wcol = optWcol;
   result.profileUpdateDelay = Seconds(optProfileUpdateDelay);
+  result.aggregateProfiles = optAggregateProfiles;
+  result.adaptiveProfileDelay = optAdaptiveProfileDelay;
+  result.maxProfileDelay = Seconds(optMaxProfileDelay);
+  result.startJitter = Seconds(optStartJitter);
+  result.broadcastJitter = Seconds(optBroadcastJitter);
+  result.rebroadcastThreshold = optRebroadcastThreshold;
+  result.electionPeriod = Seconds(optElectionPeriod);
+  result.electionBackoff = Seconds(optElectionBackoff);
+  result.electionTimeout = Seconds(optElectionTimeout);
+  result.reconcile = optReconcile;
+  result.storageCapacity = optStorageCapacity;
+  result.replicaTtl = Seconds(optReplicaTtl);
+  result.maxTransfersPerTick = optMaxTransfersPerTick;
+  result.antiPackets = optAntiPackets;
+  result.maxBatchSize = optMaxBatchSize;
+  result.batchDelay = Seconds(optBatchDelay);
+  result.dataSize = optDataSize;
+  result.fragmentSize = std::max<uint32_t>(1, optFragmentSize);
+  result.transferWindow = std::max<uint32_t>(1, optTransferWindow);
+  result.contactAware = optContactAware;
 
   result.netanimTraceFilePath = animationTraceFilePath;
+  result.fastTeardown = optFastTeardown;
+  result.useArena = optUseArena;
+  result.workerThreads = std::max<uint32_t>(1, optWorkerThreads);
 
   return std::pair<SimulationParameters, bool>(result, ok);
 }
@@ -64,6 +64,54 @@ class SimulationParameters {
   double wcol;
   /// Time between profile updates.
   ns3::Time profileUpdateDelay;
+  /// If true, the cluster head of each partition forwards the profiles of
+  /// its members instead of every node forwarding its own.
+  bool aggregateProfiles;
+  /// If true, the time between profile exchanges of each node adapts to
+  /// how often its neighborhood changes.
+  bool adaptiveProfileDelay;
+  /// The longest time between profile exchanges when it adapts.
+  ns3::Time maxProfileDelay;
+  /// The longest random delay of the first profile exchange of a node.
+  ns3::Time startJitter;
+  /// The longest random delay of each broadcast.
+  ns3::Time broadcastJitter;
+  /// The number of overheard copies of a message after which a node does not
+  /// forward it; 0 always forwards.
+  uint32_t rebroadcastThreshold;
+  /// Time between two replica holder elections.
+  ns3::Time electionPeriod;
+  /// The longest time a candidate waits before announcing itself.
+  ns3::Time electionBackoff;
+  /// Time after the start of an election at which its winner is decided.
+  ns3::Time electionTimeout;
+  /// If true, nodes reconcile their storage with each new contact instead of
+  /// knowing what their neighbors hold.
+  bool reconcile;
+  /// The number of replicas a node may hold besides its own data; 0 for no
+  /// limit.
+  uint32_t storageCapacity;
+  /// Time after which a node drops a replica it received; zero keeps replicas
+  /// forever.
+  ns3::Time replicaTtl;
+  /// The number of data items a node may send on each data tick; 0 for no limit.
+  uint32_t maxTransfersPerTick;
+  /// If true, nodes gossip which data was delivered so that other holders
+  /// drop their copies.
+  bool antiPackets;
+  /// The largest number of bytes of data items sent in one datagram; 0 sends
+  /// each item by itself.
+  uint32_t maxBatchSize;
+  /// Time for which data items are collected before they are sent together.
+  ns3::Time batchDelay;
+  /// The size of each data item in bytes; 0 sends items as their ids only.
+  uint32_t dataSize;
+  /// The largest number of bytes of a data item sent in one datagram.
+  uint32_t fragmentSize;
+  /// The largest number of fragments of a data item in flight at once.
+  uint32_t transferWindow;
+  /// Whether transfers are chosen to fit the estimated duration of each contact.
+  bool contactAware;
   /// The number of hops defining the neighborhood of the node.
   uint8_t neighborhoodSize;
   /// The number of hops defining the neighborhood considered for a replicating
@@ -96,6 +144,13 @@ class SimulationParameters {
   /// The path on disk to output the NetAnim trace XML file for visualizing the
   /// results of the simulation.
   std::string netanimTraceFilePath;
+  /// If true, the program exits right after flushing its outputs once the
+  /// simulation has finished, instead of destroying every simulated object.
+  bool fastTeardown;
+  /// If true, RHPMAN objects are allocated from a run-lifetime arena.
+  bool useArena;
+  /// The number of threads used for batch RHPMAN computations.
+  uint32_t workerThreads;
 
   SimulationParameters() {}
 
@@ -0,0 +1,98 @@
+/// \file timer-wheel-test.cc
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#include <algorithm>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+
+#include "nsutil.h"
+#include "timer-wheel.h"
+
+namespace rhpman {
+
+using namespace ns3;
+
+/// Schedules timers on the wheel while another timer is still pending and the
+/// wheel has not woken for the ticks in between, then checks that every timer
+/// runs no earlier than it is due and at most one Resolution late.
+class TimerWheelPendingTestCase : public TestCase {
+ public:
+  TimerWheelPendingTestCase() : TestCase("schedule while other timers are pending") {}
+
+ private:
+  void DoRun() override;
+  void ScheduleFirst();
+  void ScheduleSecond();
+  void Expire();
+
+  Ptr<TimerWheel> m_wheel;
+  std::vector<Time> m_due;
+  std::vector<Time> m_ran;
+};
+
+void TimerWheelPendingTestCase::DoRun() {
+  m_wheel = TimerWheel::GetInstance();
+  Simulator::Schedule(1.0_sec, &TimerWheelPendingTestCase::ScheduleFirst, this);
+  Simulator::Schedule(1.505_sec, &TimerWheelPendingTestCase::ScheduleSecond, this);
+  Simulator::Run();
+
+  NS_TEST_ASSERT_MSG_EQ(m_ran.size(), m_due.size(), "every timer ran once");
+  NS_TEST_ASSERT_MSG_EQ(m_wheel->GetPending(), 0u, "no timers are left pending");
+
+  // Timers are due in the order they were scheduled, and run in time order.
+  std::sort(m_due.begin(), m_due.end());
+  for (size_t i = 0; i < m_ran.size(); i++) {
+    NS_TEST_EXPECT_MSG_GT_OR_EQ(m_ran[i], m_due[i], "timer ran before it was due");
+    NS_TEST_EXPECT_MSG_LT(m_ran[i], m_due[i] + 0.01_sec, "timer ran more than one tick late");
+  }
+
+  m_wheel = 0;
+  Simulator::Destroy();
+}
+
+void TimerWheelPendingTestCase::ScheduleFirst() {
+  m_due.push_back(Simulator::Now() + 0.6_sec);
+  m_wheel->Schedule(0.6_sec, MakeCallback(&TimerWheelPendingTestCase::Expire, this));
+}
+
+void TimerWheelPendingTestCase::ScheduleSecond() {
+  // The first timer keeps the wheel asleep until 1.6s, so the wheel's notion
+  // of the current tick still lags at 1.0s here.
+  m_due.push_back(Simulator::Now() + 0.2_sec);
+  m_wheel->Schedule(0.2_sec, MakeCallback(&TimerWheelPendingTestCase::Expire, this));
+
+  // Far enough out to be placed on an upper level and cascade down later.
+  m_due.push_back(Simulator::Now() + 5.0_sec);
+  m_wheel->Schedule(5.0_sec, MakeCallback(&TimerWheelPendingTestCase::Expire, this));
+}
+
+void TimerWheelPendingTestCase::Expire() { m_ran.push_back(Simulator::Now()); }
+
+class TimerWheelTestSuite : public TestSuite {
+ public:
+  TimerWheelTestSuite() : TestSuite("rhpman-timer-wheel", UNIT) {
+    AddTestCase(new TimerWheelPendingTestCase, TestCase::QUICK);
+  }
+};
+
+static TimerWheelTestSuite g_timerWheelTestSuite;
+
+}  // namespace rhpman
+
+int main(int argc, char* argv[]) { return ns3::TestRunner::Run(argc, argv); }
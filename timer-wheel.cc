@@ -0,0 +1,304 @@
+/// \file timer-wheel.cc
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#include <algorithm>
+#include <vector>
+
+#include "ns3/callback.h"
+#include "ns3/core-module.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+
+#include "logging.h"
+#include "nsutil.h"
+#include "timer-wheel.h"
+
+namespace rhpman {
+
+using namespace ns3;
+
+NS_OBJECT_ENSURE_REGISTERED(TimerWheel);
+
+namespace {
+
+Ptr<TimerWheel> g_instance;
+
+void discardInstance() {
+  if (g_instance != 0) {
+    g_instance->Dispose();
+    g_instance = 0;
+  }
+}
+
+}  // namespace
+
+// static
+TypeId TimerWheel::GetTypeId() {
+  static TypeId id = TypeId("rhpman::TimerWheel")
+                         .SetParent<Object>()
+                         .AddConstructor<TimerWheel>()
+                         .AddAttribute(
+                             "Resolution",
+                             "The length of one tick of the wheel",
+                             TimeValue(0.01_sec),
+                             MakeTimeAccessor(&TimerWheel::m_resolution),
+                             MakeTimeChecker(Time(1)));
+  return id;
+}
+
+TimerWheel::TimerWheel()
+    : m_resolution(0.01_sec),
+      m_now(0),
+      m_pending(0),
+      m_entries(),
+      m_free(),
+      m_event(),
+      m_eventTick(0) {
+  std::fill(std::begin(m_heads), std::end(m_heads), kNil);
+  std::fill(std::begin(m_occupied), std::end(m_occupied), 0);
+}
+
+TimerWheel::~TimerWheel() {}
+
+// static
+Ptr<TimerWheel> TimerWheel::GetInstance() {
+  if (g_instance == 0) {
+    g_instance = CreateObject<TimerWheel>();
+    Simulator::ScheduleDestroy(&discardInstance);
+  }
+  return g_instance;
+}
+
+// static
+Ptr<TimerWheel> TimerWheel::PeekInstance() { return g_instance; }
+
+TimerWheel::Handle TimerWheel::Schedule(Time delay, Callback<void> callback) {
+  // The wheel only wakes for ticks with work, so it may lag behind the
+  // simulator clock. Every tick before the current one has passed without
+  // work, so the wheel can catch up to it; the current tick itself may still
+  // have timers to run later in this time step.
+  const uint64_t now = currentTick();
+  if (now > 0) advance(now - 1);
+
+  // Round the due time up to a whole tick, and never expire in the tick that
+  // is currently being processed.
+  const int64_t res = m_resolution.GetTimeStep();
+  const int64_t due = (Simulator::Now() + delay).GetTimeStep();
+  const uint64_t expiry = std::max<uint64_t>((due + res - 1) / res, currentTick() + 1);
+
+  uint32_t index;
+  if (m_free.empty()) {
+    index = m_entries.size();
+    m_entries.push_back(Entry());
+    m_entries[index].generation = 0;
+  } else {
+    index = m_free.back();
+    m_free.pop_back();
+  }
+
+  Entry& entry = m_entries[index];
+  entry.expiry = expiry;
+  entry.callback = callback;
+  insert(index);
+  m_pending++;
+
+  reschedule();
+  return Handle(index, entry.generation);
+}
+
+void TimerWheel::Cancel(Handle& handle) {
+  if (IsPending(handle)) {
+    unlink(handle.m_index);
+    release(handle.m_index);
+    reschedule();
+  }
+  handle = Handle();
+}
+
+bool TimerWheel::IsPending(const Handle& handle) const {
+  return handle.m_index < m_entries.size() &&
+         m_entries[handle.m_index].generation == handle.m_generation &&
+         m_entries[handle.m_index].slot != kNil;
+}
+
+// override
+void TimerWheel::DoDispose() {
+  Simulator::Cancel(m_event);
+  m_entries.clear();
+  m_free.clear();
+  m_pending = 0;
+  std::fill(std::begin(m_heads), std::end(m_heads), kNil);
+  std::fill(std::begin(m_occupied), std::end(m_occupied), 0);
+  Object::DoDispose();
+}
+
+uint64_t TimerWheel::currentTick() const {
+  return Simulator::Now().GetTimeStep() / m_resolution.GetTimeStep();
+}
+
+uint64_t TimerWheel::nextTick() const {
+  // Nearest occupied level 0 slot, searching circularly from the current one.
+  const uint32_t idx = m_now & kMask;
+  uint64_t next = UINT64_MAX;
+  const uint64_t ahead = idx == kMask ? 0 : m_occupied[0] >> (idx + 1);
+  if (ahead) {
+    next = m_now + 1 + __builtin_ctzll(ahead);
+  } else if (m_occupied[0]) {
+    next = m_now + (kSlots - idx) + __builtin_ctzll(m_occupied[0]);
+  }
+
+  // Timers in the upper levels only need attention when level 0 wraps.
+  for (uint32_t level = 1; level < kLevels; level++) {
+    if (m_occupied[level]) {
+      next = std::min(next, (m_now | kMask) + 1);
+      break;
+    }
+  }
+  return next;
+}
+
+void TimerWheel::insert(uint32_t index) {
+  Entry& entry = m_entries[index];
+  const uint64_t delta = entry.expiry > m_now ? entry.expiry - m_now : 0;
+
+  uint32_t level = 0;
+  uint64_t expiry = entry.expiry;
+  while (level < kLevels - 1 && delta >= (uint64_t(1) << (kBits * (level + 1)))) {
+    level++;
+  }
+  if (delta >= (uint64_t(1) << (kBits * kLevels))) {
+    // Beyond the range of the wheel; park the timer in the furthest slot, it
+    // is placed again with its real expiry when that slot cascades.
+    expiry = m_now + (uint64_t(1) << (kBits * kLevels)) - 1;
+  }
+
+  const uint32_t idx = (expiry >> (kBits * level)) & kMask;
+  const uint32_t slot = level * kSlots + idx;
+  entry.slot = slot;
+  entry.prev = kNil;
+  entry.next = m_heads[slot];
+  if (entry.next != kNil) {
+    m_entries[entry.next].prev = index;
+  }
+  m_heads[slot] = index;
+  m_occupied[level] |= uint64_t(1) << idx;
+}
+
+void TimerWheel::unlink(uint32_t index) {
+  Entry& entry = m_entries[index];
+  if (entry.prev != kNil) {
+    m_entries[entry.prev].next = entry.next;
+  } else {
+    m_heads[entry.slot] = entry.next;
+  }
+  if (entry.next != kNil) {
+    m_entries[entry.next].prev = entry.prev;
+  }
+  if (m_heads[entry.slot] == kNil) {
+    m_occupied[entry.slot / kSlots] &= ~(uint64_t(1) << (entry.slot & kMask));
+  }
+  entry.slot = kNil;
+}
+
+void TimerWheel::release(uint32_t index) {
+  Entry& entry = m_entries[index];
+  entry.callback = Callback<void>();
+  entry.generation++;
+  m_free.push_back(index);
+  m_pending--;
+}
+
+/// Moves the wheel up to the target tick without running any timers, cascading
+/// the upper levels at each wrap of level 0 on the way. The target must not be
+/// past a tick which still has timers to run.
+void TimerWheel::advance(uint64_t target) {
+  while (m_now < target) {
+    const uint64_t next = nextTick();
+    if (next > target) {
+      m_now = target;
+      return;
+    }
+    NS_ASSERT(m_heads[next & kMask] == kNil);
+    m_now = next;
+    cascade(1);
+  }
+}
+
+void TimerWheel::cascade(uint32_t level) {
+  if (level >= kLevels) return;
+  const uint32_t idx = (m_now >> (kBits * level)) & kMask;
+  if (idx == 0) {
+    cascade(level + 1);
+  }
+
+  const uint32_t slot = level * kSlots + idx;
+  uint32_t index = m_heads[slot];
+  m_heads[slot] = kNil;
+  m_occupied[level] &= ~(uint64_t(1) << idx);
+  while (index != kNil) {
+    const uint32_t next = m_entries[index].next;
+    insert(index);
+    index = next;
+  }
+}
+
+void TimerWheel::runSlot(uint32_t slot) {
+  // Callbacks may schedule or cancel other timers, so the slot is popped one
+  // entry at a time rather than detached as a whole.
+  while (m_heads[slot] != kNil) {
+    const uint32_t index = m_heads[slot];
+    Callback<void> callback = m_entries[index].callback;
+    unlink(index);
+    release(index);
+    callback();
+  }
+}
+
+void TimerWheel::expire() {
+  m_event = EventId();
+  const uint64_t target = currentTick();
+  while (m_pending > 0) {
+    const uint64_t next = nextTick();
+    if (next > target) break;
+    m_now = next;
+    if ((m_now & kMask) == 0) {
+      cascade(1);
+    }
+    runSlot(m_now & kMask);
+  }
+  reschedule();
+}
+
+void TimerWheel::reschedule() {
+  if (m_pending == 0) {
+    Simulator::Cancel(m_event);
+    return;
+  }
+
+  // A tick with work may already be due, either because the wheel lags behind
+  // the simulator clock or because a callback of the current tick scheduled
+  // it; its timers then run at the start of the next tick, which is never
+  // before the current time.
+  const uint64_t next = std::max(nextTick(), currentTick() + 1);
+  if (m_event.IsRunning() && m_eventTick <= next) return;
+
+  Simulator::Cancel(m_event);
+  m_eventTick = next;
+  const Time at = m_resolution * int64_t(next);
+  m_event = Simulator::Schedule(at - Simulator::Now(), &TimerWheel::expire, this);
+}
+
+}  // namespace rhpman
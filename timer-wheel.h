@@ -0,0 +1,141 @@
+/// \file timer-wheel.h
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+/// \brief Declares a hierarchical timer wheel shared by all RHPMAN apps of a
+///     simulation.
+///
+///     Every RHPMAN node runs several periodic and timeout timers. Rather than
+///     scheduling one simulator event per timer, timers are kept in the wheel,
+///     and the wheel keeps at most one simulator event pending: the one for
+///     the next tick that has work to do.
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef __timer_wheel_h
+#define __timer_wheel_h
+
+#include <inttypes.h>
+#include <vector>
+
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+
+namespace rhpman {
+
+using namespace ns3;
+
+/// \brief A hierarchical timer wheel with O(1) schedule and cancel.
+///     Simulation time is divided into ticks of the configured Resolution.
+///     Timers expire at the first tick at or after their due time, so their
+///     callbacks may run up to one Resolution late.
+///
+///     The wheel has kLevels levels of kSlots slots each. Level 0 holds timers
+///     due within kSlots ticks; each further level covers kSlots times the
+///     range of the level beneath it, and its timers cascade downwards as the
+///     wheel turns.
+class TimerWheel : public Object {
+ public:
+  static constexpr uint32_t kBits = 6;
+  static constexpr uint32_t kSlots = 1 << kBits;
+  static constexpr uint32_t kLevels = 4;
+
+  /// \brief Identifies a scheduled timer.
+  ///     Handles stay safe to use after their timer expired or was cancelled.
+  class Handle {
+   public:
+    Handle() : m_index(kNil), m_generation(0) {}
+
+   private:
+    friend class TimerWheel;
+    Handle(uint32_t index, uint32_t generation) : m_index(index), m_generation(generation) {}
+
+    uint32_t m_index;
+    uint32_t m_generation;
+  };
+
+  static TypeId GetTypeId();
+
+  TimerWheel();
+  ~TimerWheel() override;
+
+  /// \brief Gets the timer wheel of the current simulation, creating it on
+  ///     first use. It is discarded when the simulator is destroyed.
+  static Ptr<TimerWheel> GetInstance();
+
+  /// \brief Gets the timer wheel of the current simulation without creating it.
+  ///
+  /// \return Ptr<TimerWheel> The wheel, or a null pointer if there is none.
+  static Ptr<TimerWheel> PeekInstance();
+
+  /// \brief Schedules a callback to run after the given delay.
+  ///
+  /// \param delay The time to wait before running the callback.
+  /// \param callback The callback to run.
+  /// \return Handle A handle which may be used to cancel the timer.
+  Handle Schedule(Time delay, Callback<void> callback);
+
+  /// \brief Cancels a timer if it is still pending.
+  ///
+  /// \param handle The handle of the timer to cancel; it is reset.
+  void Cancel(Handle& handle);
+
+  /// \brief Checks whether a timer is still pending.
+  bool IsPending(const Handle& handle) const;
+
+  /// \brief Gets the number of pending timers.
+  uint32_t GetPending() const { return m_pending; }
+
+ protected:
+  void DoDispose() override;
+
+ private:
+  static constexpr uint32_t kNil = UINT32_MAX;
+  static constexpr uint64_t kMask = kSlots - 1;
+
+  struct Entry {
+    uint64_t expiry;
+    Callback<void> callback;
+    uint32_t prev;
+    uint32_t next;
+    uint32_t slot;
+    uint32_t generation;
+  };
+
+  uint64_t currentTick() const;
+  uint64_t nextTick() const;
+  void insert(uint32_t index);
+  void unlink(uint32_t index);
+  void release(uint32_t index);
+  void advance(uint64_t target);
+  void cascade(uint32_t level);
+  void runSlot(uint32_t slot);
+  void expire();
+  void reschedule();
+
+  Time m_resolution;
+  uint64_t m_now;
+  uint32_t m_pending;
+  std::vector<Entry> m_entries;
+  std::vector<uint32_t> m_free;
+  uint32_t m_heads[kLevels * kSlots];
+  uint64_t m_occupied[kLevels];
+  EventId m_event;
+  uint64_t m_eventTick;
+};
+
+}  // namespace rhpman
+
+#endif
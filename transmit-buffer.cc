@@ -0,0 +1,150 @@
+/// \file transmit-buffer.cc
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#include <algorithm>
+
+#include "ns3/assert.h"
+
+#include "transmit-buffer.h"
+
+namespace rhpman {
+
+TransmitBuffer::TransmitBuffer(Time bucketWidth)
+    : m_bucketWidth(std::max<int64_t>(1, bucketWidth.GetNanoSeconds())),
+      m_heap(),
+      m_position(),
+      m_buckets() {}
+
+void TransmitBuffer::Insert(uint32_t dataId, Time received, Time expiry) {
+  Insert(Entry{dataId, 0.0f, received, expiry});
+}
+
+void TransmitBuffer::Insert(const Entry& entry) {
+  if (Contains(entry.dataId)) return;
+  m_heap.push_back(entry);
+  m_position[entry.dataId] = m_heap.size() - 1;
+  siftUp(m_heap.size() - 1);
+  if (entry.expiry != Time::Max()) {
+    m_buckets[getBucket(entry.expiry)].push_back(entry.dataId);
+  }
+}
+
+void TransmitBuffer::Remove(uint32_t dataId) {
+  auto found = m_position.find(dataId);
+  if (found != m_position.end()) removeAt(found->second);
+}
+
+void TransmitBuffer::SetPriority(uint32_t dataId, float priority) {
+  auto found = m_position.find(dataId);
+  if (found == m_position.end()) return;
+  const size_t slot = found->second;
+  const float previous = m_heap[slot].priority;
+  m_heap[slot].priority = priority;
+  if (priority > previous) {
+    siftUp(slot);
+  } else if (priority < previous) {
+    siftDown(slot);
+  }
+}
+
+TransmitBuffer::Entry TransmitBuffer::Pop() {
+  NS_ASSERT(!m_heap.empty());
+  const Entry top = m_heap.front();
+  removeAt(0);
+  return top;
+}
+
+void TransmitBuffer::Expire(Time now, std::vector<uint32_t>& expired) {
+  const int64_t current = getBucket(now);
+  while (!m_buckets.empty() && m_buckets.begin()->first <= current) {
+    auto bucket = m_buckets.begin();
+    std::vector<uint32_t> later;
+    for (uint32_t dataId : bucket->second) {
+      auto found = m_position.find(dataId);
+      if (found == m_position.end()) continue;
+      const Time expiry = m_heap[found->second].expiry;
+      // The last bucket may hold items which expire after now.
+      if (getBucket(expiry) != bucket->first) continue;
+      if (expiry > now) {
+        later.push_back(dataId);
+        continue;
+      }
+      removeAt(found->second);
+      expired.push_back(dataId);
+    }
+    if (!later.empty()) {
+      bucket->second.swap(later);
+      break;
+    }
+    m_buckets.erase(bucket);
+  }
+}
+
+void TransmitBuffer::Clear() {
+  m_heap.clear();
+  m_position.clear();
+  m_buckets.clear();
+}
+
+bool TransmitBuffer::before(const Entry& a, const Entry& b) const {
+  if (a.priority != b.priority) return a.priority > b.priority;
+  if (a.received != b.received) return a.received < b.received;
+  return a.dataId < b.dataId;
+}
+
+void TransmitBuffer::place(size_t slot, const Entry& entry) {
+  m_heap[slot] = entry;
+  m_position[entry.dataId] = slot;
+}
+
+void TransmitBuffer::siftUp(size_t slot) {
+  const Entry entry = m_heap[slot];
+  while (slot > 0) {
+    const size_t parent = (slot - 1) / 2;
+    if (!before(entry, m_heap[parent])) break;
+    place(slot, m_heap[parent]);
+    slot = parent;
+  }
+  place(slot, entry);
+}
+
+void TransmitBuffer::siftDown(size_t slot) {
+  const Entry entry = m_heap[slot];
+  const size_t size = m_heap.size();
+  while (true) {
+    size_t child = 2 * slot + 1;
+    if (child >= size) break;
+    if (child + 1 < size && before(m_heap[child + 1], m_heap[child])) child++;
+    if (!before(m_heap[child], entry)) break;
+    place(slot, m_heap[child]);
+    slot = child;
+  }
+  place(slot, entry);
+}
+
+void TransmitBuffer::removeAt(size_t slot) {
+  m_position.erase(m_heap[slot].dataId);
+  const Entry moved = m_heap.back();
+  m_heap.pop_back();
+  if (slot == m_heap.size()) return;
+  place(slot, moved);
+  siftUp(slot);
+  siftDown(m_position[moved.dataId]);
+}
+
+int64_t TransmitBuffer::getBucket(Time time) const { return time.GetNanoSeconds() / m_bucketWidth; }
+
+}  // namespace rhpman
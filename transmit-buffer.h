@@ -0,0 +1,107 @@
+/// \file transmit-buffer.h
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+/// \brief Declares the buffer which orders the data items a node sends to its
+///     neighbors.
+///
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+
+#ifndef __transmit_buffer_h
+#define __transmit_buffer_h
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "ns3/nstime.h"
+
+namespace rhpman {
+
+using namespace ns3;
+
+/// \brief Orders the data items held by a node for transmission, by the
+///     highest delivery probability among the neighbors which should receive
+///     them, then by the time the node received them, oldest first.
+///     Items are kept in a binary max-heap along with the position of each
+///     item in it, so the priority of any item can be changed in O(log n).
+///
+///     Items may also expire. Rather than one timer per item, expiry times
+///     are grouped into buckets of a fixed width, and Expire only visits the
+///     buckets which have ended.
+class TransmitBuffer {
+ public:
+  /// \brief An item in the buffer.
+  struct Entry {
+    uint32_t dataId;
+    float priority;
+    /// When the node received the item.
+    Time received;
+    /// When the item expires; Time::Max() if it never does.
+    Time expiry;
+  };
+
+  /// \param bucketWidth The width of the expiry buckets.
+  explicit TransmitBuffer(Time bucketWidth = Seconds(1));
+
+  size_t GetSize() const { return m_heap.size(); }
+  bool IsEmpty() const { return m_heap.empty(); }
+  bool Contains(uint32_t dataId) const { return m_position.count(dataId) > 0; }
+
+  /// \brief Adds an item with no priority; does nothing if it is present.
+  void Insert(uint32_t dataId, Time received, Time expiry);
+
+  /// \brief Adds an item which was popped from the buffer back to it.
+  void Insert(const Entry& entry);
+
+  void Remove(uint32_t dataId);
+
+  /// \brief Changes the priority of an item in the buffer.
+  void SetPriority(uint32_t dataId, float priority);
+
+  /// \brief Gets the item which should be sent first.
+  const Entry& Top() const { return m_heap.front(); }
+
+  /// \brief Removes and returns the item which should be sent first.
+  Entry Pop();
+
+  /// \brief Removes every item which expires at or before a time.
+  ///
+  /// \param now The current time.
+  /// \param expired Receives the ids of the removed items.
+  void Expire(Time now, std::vector<uint32_t>& expired);
+
+  void Clear();
+
+ private:
+  bool before(const Entry& a, const Entry& b) const;
+  void place(size_t slot, const Entry& entry);
+  void siftUp(size_t slot);
+  void siftDown(size_t slot);
+  void removeAt(size_t slot);
+  int64_t getBucket(Time time) const;
+
+  int64_t m_bucketWidth;
+  std::vector<Entry> m_heap;
+  std::unordered_map<uint32_t, size_t> m_position;
+  // Ids of the items which expire in each bucket. Items may have been
+  // removed since, or inserted again with another expiry.
+  std::map<int64_t, std::vector<uint32_t>> m_buckets;
+};
+
+}  // namespace rhpman
+
+#endif
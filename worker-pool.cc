@@ -0,0 +1,103 @@
+/// \file worker-pool.cc
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+#include "worker-pool.h"
+
+namespace rhpman {
+
+WorkerPool::WorkerPool(uint32_t threads)
+    : m_workers(),
+      m_stop(false),
+      m_generation(0),
+      m_running(0),
+      m_job(nullptr),
+      m_items(0),
+      m_blocks(0),
+      m_nextBlock(0) {
+  for (uint32_t i = 1; i < threads; i++) {
+    m_workers.emplace_back(&WorkerPool::workerLoop, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (std::thread& worker : m_workers) {
+    worker.join();
+  }
+}
+
+void WorkerPool::ForEachBlock(uint32_t items, const Job& job) {
+  const uint32_t blocks = GetBlocks(items);
+  if (m_workers.empty() || blocks <= 1) {
+    for (uint32_t block = 0; block < blocks; block++) {
+      job(block, block * kBlockSize, std::min(items, (block + 1) * kBlockSize));
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_job = &job;
+    m_items = items;
+    m_blocks = blocks;
+    m_nextBlock = 0;
+    m_running = m_workers.size();
+    m_generation++;
+  }
+  m_wake.notify_all();
+
+  runBlocks();
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock, [this] { return m_running == 0; });
+  m_job = nullptr;
+}
+
+void WorkerPool::workerLoop() {
+  uint64_t seen = 0;
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (;;) {
+    m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+    if (m_stop) return;
+    seen = m_generation;
+
+    lock.unlock();
+    runBlocks();
+    lock.lock();
+
+    if (--m_running == 0) {
+      m_done.notify_one();
+    }
+  }
+}
+
+void WorkerPool::runBlocks() {
+  for (;;) {
+    const uint32_t block = m_nextBlock.fetch_add(1);
+    if (block >= m_blocks) return;
+    (*m_job)(block, block * kBlockSize, std::min(m_items, (block + 1) * kBlockSize));
+  }
+}
+
+}  // namespace rhpman
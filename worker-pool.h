@@ -0,0 +1,113 @@
+/// \file worker-pool.h
+/// \author Keefer Rourke <krourke@uoguelph.ca>
+/// \brief Declares a pool of worker threads for batch computations that run
+///     inside a single simulator event.
+///
+///     Work is always split into the same fixed-size blocks, no matter how many
+///     threads there are, and per-block results are combined in block order.
+///     Computations therefore give bit-identical results with any number of
+///     threads, including when running serially.
+///
+/// Copyright (c) 2020 by Keefer Rourke <krourke@uoguelph.ca>
+/// Permission to use, copy, modify, and/or distribute this software for any
+/// purpose with or without fee is hereby granted, provided that the above
+/// copyright notice and this permission notice appear in all copies.
+///
+/// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+/// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+/// AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+/// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+/// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+/// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+/// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef __worker_pool_h
+#define __worker_pool_h
+
+#include <inttypes.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rhpman {
+
+/// \brief A fixed set of threads which run blocks of a batch computation.
+///     The calling thread takes part in every batch, so a pool of one thread
+///     starts no workers at all.
+///
+///     Jobs must not touch the simulator, or any other shared state that is
+///     not partitioned by block. In particular, they must not allocate from
+///     the run Arena, which is not thread-safe.
+class WorkerPool {
+ public:
+  /// The number of items in each block.
+  static constexpr uint32_t kBlockSize = 256;
+
+  /// A job processes the items in [begin, end), which make up one block.
+  using Job = std::function<void(uint32_t block, uint32_t begin, uint32_t end)>;
+
+  explicit WorkerPool(uint32_t threads);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  uint32_t GetThreads() const { return m_workers.size() + 1; }
+
+  /// \brief Gets the number of blocks that a batch of items is split into.
+  static uint32_t GetBlocks(uint32_t items) { return (items + kBlockSize - 1) / kBlockSize; }
+
+  /// \brief Runs a job on every block of a batch, and waits for all of them to
+  ///     finish. Blocks may run in any order and on any thread.
+  ///
+  /// \param items The number of items in the batch.
+  /// \param job The job to run for each block.
+  void ForEachBlock(uint32_t items, const Job& job);
+
+  /// \brief Maps every block of a batch to a value, then combines the values
+  ///     in block order.
+  ///
+  /// \param items The number of items in the batch.
+  /// \param identity The initial value of the reduction.
+  /// \param map Computes the value of the items in [begin, end).
+  /// \param combine Combines the running value with the value of a block.
+  /// \return T The combined value.
+  template <typename T, typename Map, typename Combine>
+  T Reduce(uint32_t items, T identity, Map map, Combine combine) {
+    std::vector<T> partials(GetBlocks(items), identity);
+    ForEachBlock(items, [&](uint32_t block, uint32_t begin, uint32_t end) {
+      partials[block] = map(begin, end);
+    });
+    T result = identity;
+    for (const T& partial : partials) {
+      result = combine(result, partial);
+    }
+    return result;
+  }
+
+ private:
+  void workerLoop();
+  void runBlocks();
+
+  std::vector<std::thread> m_workers;
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  bool m_stop;
+  uint64_t m_generation;
+  uint32_t m_running;
+
+  // The batch currently being processed.
+
+  const Job* m_job;
+  uint32_t m_items;
+  uint32_t m_blocks;
+  std::atomic<uint32_t> m_nextBlock;
+};
+
+}  // namespace rhpman
+
+#endif